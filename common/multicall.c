@@ -0,0 +1,215 @@
+// every tool of ex1-ex3 in one binary, busybox style:
+//   gcc -O2 -pthread -o ostools common/multicall.c common/multicall/*.c
+//   ./ostools file_sync src dst          (or a link named file_sync -> ostools)
+// the tools' helpers come along as builtins: os_spawn_wait runs mkdir, cp and diff in-process
+// instead of spawning them, and os_spawn starts a subcommand (the tournament's ./gladiator)
+// as /proc/self/exe, so nothing needs to be installed next to the binary
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "os_instrument.h"
+
+#define COPY_CHUNK (1 << 16)
+
+int file_sync_main(int argc, char* argv[]);
+int backup_main(int argc, char* argv[]);
+int file_processor_main(int argc, char* argv[]);
+int tournament_main(int argc, char* argv[]);
+int gladiator_main(int argc, char* argv[]);
+int render_log_main(int argc, char* argv[]);
+int ex3_main(int argc, char* argv[]);
+
+// mkdir [-p] dir: always with the parents, an existing directory is fine
+static int builtin_mkdir(int argc, char* argv[], int quiet) {
+    (void)quiet;
+    const char* dir = argv[argc - 1];
+    if (argc < 2 || dir[0] == '-') {
+        fprintf(stderr, "mkdir: missing operand\n");
+        return 1;
+    }
+    char path[4096];
+    snprintf(path, sizeof(path), "%s", dir);
+    for (char* p = path + 1; ; p++) {
+        if (*p != '/' && *p != '\0') continue;
+        char end = *p;
+        *p = '\0';
+        struct stat st;
+        if (mkdir(path, 0777) < 0 && (errno != EEXIST || stat(path, &st) < 0 || !S_ISDIR(st.st_mode))) {
+            fprintf(stderr, "mkdir: %s: %s\n", path, strerror(errno ? errno : EEXIST));
+            return 1;
+        }
+        *p = end;
+        if (end == '\0') break;
+    }
+    return 0;
+}
+
+// cp src dst (dst may be a directory), with src's permission bits like cp
+static int builtin_cp(int argc, char* argv[], int quiet) {
+    (void)quiet;
+    if (argc != 3) {
+        fprintf(stderr, "cp: expected a source and a destination\n");
+        return 1;
+    }
+    char target[4096];
+    struct stat st;
+    snprintf(target, sizeof(target), "%s", argv[2]);
+    if (stat(argv[2], &st) == 0 && S_ISDIR(st.st_mode)) {
+        const char* slash = strrchr(argv[1], '/');
+        snprintf(target, sizeof(target), "%s/%s", argv[2], slash ? slash + 1 : argv[1]);
+    }
+
+    int in = open(argv[1], O_RDONLY);
+    if (in < 0 || fstat(in, &st) < 0) {
+        fprintf(stderr, "cp: %s: %s\n", argv[1], strerror(errno));
+        if (in >= 0) close(in);
+        return 1;
+    }
+    int out = open(target, O_WRONLY | O_CREAT | O_TRUNC, st.st_mode & 07777);
+    if (out < 0) {
+        fprintf(stderr, "cp: %s: %s\n", target, strerror(errno));
+        close(in);
+        return 1;
+    }
+    char buffer[COPY_CHUNK];
+    int status = 0;
+    while (1) {
+        unsigned long long t = os_instrument_begin();
+        ssize_t n = read(in, buffer, sizeof(buffer));
+        os_instrument_end_bytes(OS_READ, t, n);
+        if (n == 0) break;
+        if (n < 0) {
+            status = 1;
+            break;
+        }
+        for (ssize_t done = 0; done < n && status == 0;) {
+            t = os_instrument_begin();
+            ssize_t w = write(out, buffer + done, n - done);
+            os_instrument_end_bytes(OS_WRITE, t, w);
+            if (w < 0) status = 1;
+            else done += w;
+        }
+        if (status) break;
+    }
+    if (status) fprintf(stderr, "cp: %s: %s\n", target, strerror(errno));
+    close(in);
+    if (close(out) < 0) status = 1;
+    return status;
+}
+
+// diff [-q] a b, only whether they differ: 0 same, 1 different, 2 trouble
+static int builtin_diff(int argc, char* argv[], int quiet) {
+    if (argc < 3) {
+        fprintf(stderr, "diff: missing operand\n");
+        return 2;
+    }
+    const char* a = argv[argc - 2];
+    const char* b = argv[argc - 1];
+    int fa = open(a, O_RDONLY), fb = open(b, O_RDONLY);
+    struct stat sa, sb;
+    if (fa < 0 || fb < 0 || fstat(fa, &sa) < 0 || fstat(fb, &sb) < 0) {
+        fprintf(stderr, "diff: %s: %s\n", fa < 0 ? a : b, strerror(errno));
+        if (fa >= 0) close(fa);
+        if (fb >= 0) close(fb);
+        return 2;
+    }
+    int status = sa.st_size != sb.st_size;
+    static char bufferA[COPY_CHUNK], bufferB[COPY_CHUNK];
+    while (status == 0) {
+        ssize_t na = read(fa, bufferA, sizeof(bufferA));
+        ssize_t nb = na > 0 ? read(fb, bufferB, na) : 0;
+        if (na < 0 || nb < 0) {
+            status = 2;
+        } else if (na == 0) {
+            break;
+        } else if (nb != na || memcmp(bufferA, bufferB, na) != 0) {
+            status = 1;
+        }
+    }
+    close(fa);
+    close(fb);
+    if (status == 1 && !quiet) printf("Files %s and %s differ\n", a, b);
+    return status;
+}
+
+typedef struct {
+    const char* name;
+    int (*main)(int argc, char* argv[]);
+} subcommand;
+
+static const subcommand subcommands[] = {
+    {"file_sync", file_sync_main},
+    {"backup", backup_main},
+    {"file_processor", file_processor_main},
+    {"tournament", tournament_main},
+    {"gladiator", gladiator_main},
+    {"render_log", render_log_main},
+    {"ex3", ex3_main},
+};
+
+typedef struct {
+    const char* name;
+    int (*run)(int argc, char* argv[], int quiet);
+} builtin;
+
+static const builtin builtins[] = {
+    {"mkdir", builtin_mkdir},
+    {"cp", builtin_cp},
+    {"diff", builtin_diff},
+};
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+static const subcommand* find_subcommand(const char* name) {
+    for (int i = 0; i < COUNT(subcommands); i++) {
+        if (strcmp(subcommands[i].name, name) == 0) return &subcommands[i];
+    }
+    return NULL;
+}
+
+static const builtin* find_builtin(const char* name) {
+    for (int i = 0; i < COUNT(builtins); i++) {
+        if (strcmp(builtins[i].name, name) == 0) return &builtins[i];
+    }
+    return NULL;
+}
+
+// the hooks of os_spawn.h
+int os_builtin_run(const char* name, int argc, char* argv[], int quiet) {
+    const builtin* b = find_builtin(name);
+    if (!b) return -1;
+    // a helper's stdout goes to the caller's, flush ours first so the order holds
+    if (!quiet) fflush(stdout);
+    return b->run(argc, argv, quiet);
+}
+
+int os_multicall_has(const char* name) {
+    return find_subcommand(name) != NULL;
+}
+
+int main(int argc, char* argv[]) {
+    const char* slash = strrchr(argv[0], '/');
+    const char* name = slash ? slash + 1 : argv[0];
+    // called by our own name: the subcommand is the first argument
+    if (!find_subcommand(name) && !find_builtin(name) && argc > 1) {
+        argv++;
+        argc--;
+        name = argv[0];
+    }
+
+    const subcommand* command = find_subcommand(name);
+    if (command) return command->main(argc, argv);
+    const builtin* b = find_builtin(name);
+    if (b) return b->run(argc, argv, 0);
+
+    fprintf(stderr, "Usage: %s <subcommand> [args...]\nsubcommands:", argv[0]);
+    for (int i = 0; i < COUNT(subcommands); i++) fprintf(stderr, " %s", subcommands[i].name);
+    for (int i = 0; i < COUNT(builtins); i++) fprintf(stderr, " %s", builtins[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+}
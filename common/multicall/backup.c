@@ -0,0 +1,3 @@
+// backup as a subcommand of the multicall binary (../multicall.c)
+#define main backup_main
+#include "../../ex2/backup.c"
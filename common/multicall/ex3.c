@@ -0,0 +1,3 @@
+// ex3 as a subcommand of the multicall binary (../multicall.c)
+#define main ex3_main
+#include "../../ex3/ex3.c"
@@ -0,0 +1,3 @@
+// file_processor as a subcommand of the multicall binary (../multicall.c)
+#define main file_processor_main
+#include "../../ex2/file_processor.c"
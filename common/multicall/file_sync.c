@@ -0,0 +1,3 @@
+// file_sync as a subcommand of the multicall binary (../multicall.c)
+#define main file_sync_main
+#include "../../ex1/file_sync.c"
@@ -0,0 +1,3 @@
+// render_log as a subcommand of the multicall binary (../multicall.c)
+#define main render_log_main
+#include "../../ex2/render_log.c"
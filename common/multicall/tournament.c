@@ -0,0 +1,4 @@
+// tournament as a subcommand of the multicall binary (../multicall.c)
+// gladiator_main comes with it, from gladiator.c
+#define main tournament_main
+#include "../../ex2/tournament.c"
@@ -0,0 +1,159 @@
+#ifndef OS_INSTRUMENT_H
+#define OS_INSTRUMENT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// OS_INSTRUMENT=1 (or table) prints a table of the timed calls to stderr at exit, OS_INSTRUMENT=json
+// prints the same as one JSON line. unset, every probe costs one load and a branch
+#define OS_INSTRUMENT_ENV "OS_INSTRUMENT"
+
+typedef enum {
+    OS_SPAWN,  // fork (timed on its own, see os_instrument_init), posix_spawn, pthread_create
+    OS_WAIT,   // waitpid / wait / pthread_join
+    OS_STAT,
+    OS_LINK,   // link, symlink, readlink
+    OS_COPY,   // a whole file or directory copy
+    OS_READ,
+    OS_WRITE,
+    OS_PROBE_COUNT
+} os_probe;
+
+static const char* os_probe_names[OS_PROBE_COUNT] = {"spawn", "wait", "stat", "link", "copy", "read", "write"};
+
+typedef struct {
+    unsigned long long calls;
+    unsigned long long totalNs;
+    unsigned long long maxNs;
+    unsigned long long bytes;
+} os_probe_counter;
+
+// every thread counts into its own block, no locks or atomics on the hot path. the blocks are
+// never freed, so the summary still sees the threads that already ended
+typedef struct os_counters {
+    os_probe_counter probes[OS_PROBE_COUNT];
+    struct os_counters* next;
+} os_counters;
+
+typedef enum { OS_INSTRUMENT_OFF, OS_INSTRUMENT_TABLE, OS_INSTRUMENT_JSON } os_instrument_mode;
+
+// weak, so when several files of one program include this (the multicall binary) they all
+// share one set of counters and one summary
+__attribute__((weak)) os_instrument_mode os_instrument_on = OS_INSTRUMENT_OFF;
+__attribute__((weak)) int os_instrument_ready = 0;
+__attribute__((weak)) os_counters* os_instrument_threads = NULL;
+__attribute__((weak)) pthread_mutex_t os_instrument_lock = PTHREAD_MUTEX_INITIALIZER;
+__attribute__((weak)) __thread os_counters* os_instrument_local = NULL;
+__attribute__((weak)) __thread unsigned long long os_instrument_fork_start = 0;
+
+static inline unsigned long long os_instrument_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// slow path, once per thread
+static os_counters* os_instrument_register(void) {
+    os_counters* counters = calloc(1, sizeof(*counters));
+    if (!counters) return NULL;
+    pthread_mutex_lock(&os_instrument_lock);
+    counters->next = os_instrument_threads;
+    os_instrument_threads = counters;
+    pthread_mutex_unlock(&os_instrument_lock);
+    os_instrument_local = counters;
+    return counters;
+}
+
+// start of a timed call, 0 when instrumentation is off
+static inline unsigned long long os_instrument_begin(void) {
+    return os_instrument_on ? os_instrument_now() : 0;
+}
+
+static inline void os_instrument_end_bytes(os_probe probe, unsigned long long start, long long bytes) {
+    if (!start) return;
+    unsigned long long elapsed = os_instrument_now() - start;
+    os_counters* counters = os_instrument_local ? os_instrument_local : os_instrument_register();
+    if (!counters) return;
+    os_probe_counter* counter = &counters->probes[probe];
+    counter->calls++;
+    counter->totalNs += elapsed;
+    if (elapsed > counter->maxNs) counter->maxNs = elapsed;
+    if (bytes > 0) counter->bytes += bytes;
+}
+
+static inline void os_instrument_end(os_probe probe, unsigned long long start) {
+    os_instrument_end_bytes(probe, start, 0);
+}
+
+static void os_instrument_summary(void) {
+    os_probe_counter total[OS_PROBE_COUNT];
+    memset(total, 0, sizeof(total));
+    int threads = 0;
+    pthread_mutex_lock(&os_instrument_lock);
+    for (os_counters* c = os_instrument_threads; c; c = c->next) {
+        int used = 0;
+        for (int p = 0; p < OS_PROBE_COUNT; p++) {
+            used |= c->probes[p].calls != 0;
+            total[p].calls += c->probes[p].calls;
+            total[p].totalNs += c->probes[p].totalNs;
+            total[p].bytes += c->probes[p].bytes;
+            if (c->probes[p].maxNs > total[p].maxNs) total[p].maxNs = c->probes[p].maxNs;
+        }
+        threads += used;
+    }
+    pthread_mutex_unlock(&os_instrument_lock);
+    if (!threads) return; // nothing timed, e.g. a forked child that only computed
+
+    if (os_instrument_on == OS_INSTRUMENT_JSON) {
+        fprintf(stderr, "{\"pid\": %d, \"threads\": %d, \"probes\": {", (int)getpid(), threads);
+        int first = 1;
+        for (int p = 0; p < OS_PROBE_COUNT; p++) {
+            if (!total[p].calls) continue;
+            fprintf(stderr, "%s\"%s\": {\"calls\": %llu, \"total_ns\": %llu, \"max_ns\": %llu, \"bytes\": %llu}",
+                    first ? "" : ", ", os_probe_names[p], total[p].calls, total[p].totalNs, total[p].maxNs,
+                    total[p].bytes);
+            first = 0;
+        }
+        fprintf(stderr, "}}\n");
+        return;
+    }
+    fprintf(stderr, "== os_instrument: pid %d, %d thread(s) ==\n", (int)getpid(), threads);
+    fprintf(stderr, "%-8s %10s %12s %10s %10s %12s\n", "probe", "calls", "total_ms", "avg_us", "max_us", "bytes");
+    for (int p = 0; p < OS_PROBE_COUNT; p++) {
+        if (!total[p].calls) continue;
+        fprintf(stderr, "%-8s %10llu %12.3f %10.1f %10.1f %12llu\n", os_probe_names[p], total[p].calls,
+                total[p].totalNs / 1e6, total[p].totalNs / 1e3 / total[p].calls, total[p].maxNs / 1e3,
+                total[p].bytes);
+    }
+}
+
+static void os_instrument_before_fork(void) {
+    os_instrument_fork_start = os_instrument_begin();
+}
+
+static void os_instrument_parent_after_fork(void) {
+    os_instrument_end(OS_SPAWN, os_instrument_fork_start);
+}
+
+// a forked child starts counting from zero, the calls before the fork are the parent's to report
+static void os_instrument_child_after_fork(void) {
+    for (os_counters* c = os_instrument_threads; c; c = c->next) memset(c->probes, 0, sizeof(c->probes));
+    pthread_mutex_init(&os_instrument_lock, NULL);
+}
+
+__attribute__((constructor)) static void os_instrument_init(void) {
+    if (os_instrument_ready) return;
+    os_instrument_ready = 1;
+    const char* mode = getenv(OS_INSTRUMENT_ENV);
+    if (!mode || !*mode || strcmp(mode, "0") == 0) return;
+    os_instrument_on = strcmp(mode, "json") == 0 ? OS_INSTRUMENT_JSON : OS_INSTRUMENT_TABLE;
+    // every fork() of the program is timed here, the callers only time the other probes
+    pthread_atfork(os_instrument_before_fork, os_instrument_parent_after_fork, os_instrument_child_after_fork);
+    atexit(os_instrument_summary);
+}
+
+#endif
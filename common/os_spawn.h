@@ -0,0 +1,75 @@
+#ifndef OS_SPAWN_H
+#define OS_SPAWN_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "os_instrument.h"
+
+extern char** environ;
+
+// defined by the multicall binary (common/multicall.c). a tool built on its own links without
+// them and always spawns
+int os_builtin_run(const char* name, int argc, char* argv[], int quiet) __attribute__((weak));
+int os_multicall_has(const char* name) __attribute__((weak));
+
+// /dev/null, opened on the first quiet spawn and kept for the next ones
+static int os_spawn_null_fd = -1;
+
+static inline const char* os_spawn_basename(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+// start path with argv, stdout to /dev/null when quiet. glibc's posix_spawn clones with
+// CLONE_VM | CLONE_VFORK, so unlike fork it doesn't copy our page tables and costs the same
+// whatever our size. inside the multicall binary, a program it has as a subcommand is started
+// as /proc/self/exe instead (argv[0] picks the subcommand). returns the pid, -1 with errno set
+static inline pid_t os_spawn(const char* path, char* const argv[], int quiet) {
+    posix_spawn_file_actions_t actions, *use = NULL;
+    if (quiet) {
+        if (os_spawn_null_fd < 0) os_spawn_null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (os_spawn_null_fd < 0) return -1;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, os_spawn_null_fd, STDOUT_FILENO);
+        use = &actions;
+    }
+    const char* program = path;
+    if (os_multicall_has && os_multicall_has(os_spawn_basename(path))) program = "/proc/self/exe";
+
+    pid_t pid;
+    unsigned long long t = os_instrument_begin();
+    int err = posix_spawn(&pid, program, use, NULL, argv, environ);
+    os_instrument_end(OS_SPAWN, t);
+    if (use) posix_spawn_file_actions_destroy(use);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return pid;
+}
+
+// run path to the end and return its exit status (failure if it couldn't run or was killed).
+// in the multicall binary a builtin of the same name (mkdir, cp, diff) runs in-process instead
+static inline int os_spawn_wait(const char* path, char* const argv[], int quiet, int failure) {
+    if (os_builtin_run) {
+        int argc = 0;
+        while (argv[argc]) argc++;
+        int status = os_builtin_run(os_spawn_basename(path), argc, (char**)argv, quiet);
+        if (status >= 0) return status;
+    }
+
+    pid_t pid = os_spawn(path, argv, quiet);
+    if (pid < 0) return failure;
+    int st;
+    unsigned long long t = os_instrument_begin();
+    pid_t done = waitpid(pid, &st, 0);
+    os_instrument_end(OS_WAIT, t);
+    if (done < 0) return failure;
+    return WIFEXITED(st) ? WEXITSTATUS(st) : failure;
+}
+
+#endif
@@ -9,27 +9,17 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <strings.h>       
+#include "../common/os_instrument.h"
+#include "../common/os_spawn.h"
 
 #define MAX_PATH_LEN 1024
 #define MAX_FILES     100
 
 // Function to create destination directory
 static void create_destination_directory(const char *dest_dir) {
-    // create child procces to use execl
-    pid_t pid = fork();
-    if (pid < 0) {
-         perror("fork failed"); exit(1);
-    }
-
-    if (pid == 0) {
-        execl("/bin/mkdir", "mkdir", "-p", dest_dir, NULL);
-        perror("exec mkdir failed");
-        _exit(1);
-    }
-
-    int st;
-    waitpid(pid, &st, 0);
-    if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) {
+    // spawn mkdir (in-process in the multicall binary)
+    char *args[] = {"mkdir", "-p", (char *)dest_dir, NULL};
+    if (os_spawn_wait("/bin/mkdir", args, 0, 1) != 0) {
         fprintf(stderr, "mkdir failed: %s\n", strerror(errno));
         exit(1);
     }
@@ -54,47 +44,29 @@ static void get_absolute_path(const char *path, char *abs_path) {
 // Function to check if a file is exist in the dir
 static int file_exist(const char *path) {
     struct stat st;
-    return stat(path, &st) == 0;
+    unsigned long long t = os_instrument_begin();
+    int found = stat(path, &st) == 0;
+    os_instrument_end(OS_STAT, t);
+    return found;
 }
 
 
-// Function to compare between the files in src and dest by exec->diff
+// Function to compare between the files in src and dest by diff
 static int compare_files(const char *src, const char *dst) {
-    // create child procces to use execl
-    pid_t pid = fork();
-    if (pid < 0) {
-        perror("fork failed"); return 2;
-    }
-
-    if (pid == 0) {
-        int null_fd = open("/dev/null", O_WRONLY);
-        dup2(null_fd, STDOUT_FILENO);
-        close(null_fd);
-        execl("/usr/bin/diff", "diff", "-q", src, dst, NULL);
-        _exit(2);
-    }
-    int st;
-    waitpid(pid, &st, 0);
-    return WIFEXITED(st) ? WEXITSTATUS(st) : 2;
+    // spawn diff with its output to /dev/null
+    char *args[] = {"diff", "-q", (char *)src, (char *)dst, NULL};
+    return os_spawn_wait("/usr/bin/diff", args, 1, 2);
 }
 
 
-// copy file from src to dest by execl->cp
+// copy file from src to dest by cp
 static int copy_file(const char *src, const char *dst)
 {
-    pid_t pid = fork();
-    if (pid < 0) { perror("fork failed"); return 1; }
-
-    if (pid == 0) {
-        int null_fd = open("/dev/null", O_WRONLY);
-        dup2(null_fd, STDOUT_FILENO);
-        close(null_fd);
-        execl("/bin/cp", "cp", src, dst, NULL);
-        _exit(1);
-    }
-    int st;
-    waitpid(pid, &st, 0);
-    return WIFEXITED(st) ? WEXITSTATUS(st) : 1;
+    unsigned long long copy = os_instrument_begin();
+    char *args[] = {"cp", (char *)src, (char *)dst, NULL};
+    int status = os_spawn_wait("/bin/cp", args, 1, 1);
+    os_instrument_end(OS_COPY, copy);
+    return status;
 }
 
 
@@ -127,7 +99,10 @@ static void sync_files(const char *src_dir, const char *dst_dir) {
         snprintf(dst_path, sizeof(dst_path), "%s/%s", dst_dir, e->d_name);
 
         struct stat src_stat;
-        if (stat(src_path, &src_stat) == -1 || !S_ISREG(src_stat.st_mode))
+        unsigned long long t = os_instrument_begin();
+        int found = stat(src_path, &src_stat) == 0;
+        os_instrument_end(OS_STAT, t);
+        if (!found || !S_ISREG(src_stat.st_mode))
             continue;
 
         // if their is a missing
@@ -148,7 +123,10 @@ static void sync_files(const char *src_dir, const char *dst_dir) {
             printf("File %s is identical. Skipping...\n", e->d_name);
         } else if (diff == 1) {
             struct stat dst_stat;
-            if (stat(dst_path, &dst_stat) == -1) {
+            t = os_instrument_begin();
+            found = stat(dst_path, &dst_stat) == 0;
+            os_instrument_end(OS_STAT, t);
+            if (!found) {
                 perror("stat dest"); continue;
             }
             if (src_stat.st_mtime > dst_stat.st_mtime) { 
@@ -0,0 +1,1121 @@
+// native checker for split_pgn.sh and chess_sim.sh. every game is loaded in memory, replayed on a
+// pool of threads with our own move generator, and chess_sim.py's boards are rendered in-process,
+// so no python runs per game:
+//   gcc -O2 -pthread -o chess_check chess_check.c
+//   ./chess_check pgns/Alburt.pgn splited_pgns/capmemel24          replay every game
+//   ./chess_check --split pgns/Alburt.pgn splited_pgns/Alburt       + split_pgn.sh's files for it
+//   ./chess_check --config tests_config.json                        the tests of tester.sh
+//   ./chess_check --show filtered_games/Alburt/Alburt_100.pgn ssnddq     what chess_sim.py prints
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define MAX_MOVES  256
+#define MAX_TAGS   64
+#define MAX_SHOWN  50      // failures printed, the rest only counted
+#define BATCH      64      // games a worker takes at a time
+
+extern char** environ;
+
+// ---- the board ----
+
+typedef struct {
+    char sq[64];     // 'PNBRQK' white, 'pnbrqk' black, '.' empty. a1 = 0, h1 = 7, h8 = 63
+    int white;       // white to move
+    int castling;    // 1 white short, 2 white long, 4 black short, 8 black long
+    int ep;          // en passant target square, -1 if none
+} position;
+
+typedef struct {
+    signed char from, to;
+    char promo;      // 'Q', 'R', 'B', 'N' or 0
+} move;
+
+// even: rook directions, odd: bishop directions
+static const int steps[8][2] = {{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
+static const int jumps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+
+static void start_position(position* p) {
+    memcpy(p->sq, "RNBQKBNRPPPPPPPP................................pppppppprnbqkbnr", 64);
+    p->white = 1;
+    p->castling = 15;
+    p->ep = -1;
+}
+
+static int on_board(int file, int rank) {
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+}
+
+// plain ASCII on purpose, the <ctype.h> calls show up on a million games
+static char piece_of(char type, int white) {
+    return white ? type : type | 0x20;
+}
+
+static char type_of(char piece) {
+    return piece & ~0x20;
+}
+
+static int own(char c, int white) {
+    return white ? c >= 'A' && c <= 'Z' : c >= 'a' && c <= 'z';
+}
+
+static int enemy(char c, int white) {
+    return own(c, !white);
+}
+
+static int attacked(const position* p, int square, int by_white) {
+    int file = square % 8, rank = square / 8;
+    char knight = piece_of('N', by_white), king = piece_of('K', by_white), queen = piece_of('Q', by_white);
+    int behind = by_white ? rank - 1 : rank + 1;
+    for (int df = -1; df <= 1; df += 2) {
+        if (on_board(file + df, behind) && p->sq[behind * 8 + file + df] == piece_of('P', by_white)) return 1;
+    }
+    for (int i = 0; i < 8; i++) {
+        int f = file + jumps[i][0], r = rank + jumps[i][1];
+        if (on_board(f, r) && p->sq[r * 8 + f] == knight) return 1;
+        f = file + steps[i][0];
+        r = rank + steps[i][1];
+        if (on_board(f, r) && p->sq[r * 8 + f] == king) return 1;
+        char slider = piece_of(i % 2 ? 'B' : 'R', by_white);
+        for (; on_board(f, r); f += steps[i][0], r += steps[i][1]) {
+            char c = p->sq[r * 8 + f];
+            if (c == '.') continue;
+            if (c == slider || c == queen) return 1;
+            break;
+        }
+    }
+    return 0;
+}
+
+static int in_check(const position* p, int white) {
+    const char* king = memchr(p->sq, piece_of('K', white), 64);
+    return king && attacked(p, king - p->sq, !white);
+}
+
+static int add(move* out, int n, int from, int to, char promo, int target) {
+    if (target >= 0 && to != target) return n;
+    out[n].from = from;
+    out[n].to = to;
+    out[n].promo = promo;
+    return n + 1;
+}
+
+// pseudo-legal moves of the side to move, only of the given piece type ('P'...'K', 0 for any)
+// and to the target square (-1 for any)
+static int generate(const position* p, char type, int target, move* out) {
+    int n = 0, white = p->white;
+    for (int from = 0; from < 64; from++) {
+        char c = p->sq[from];
+        if (!own(c, white) || (type && type_of(c) != type)) continue;
+        int file = from % 8, rank = from / 8;
+        switch (type_of(c)) {
+        case 'P': {
+            int forward = white ? 1 : -1, r = rank + forward;
+            if (r < 0 || r > 7) break;
+            for (int df = -1; df <= 1; df++) {
+                if (!on_board(file + df, r)) continue;
+                int to = r * 8 + file + df;
+                char there = p->sq[to];
+                if (df == 0 ? there != '.' : !(enemy(there, white) || to == p->ep)) continue;
+                if (r == 0 || r == 7) {
+                    for (const char* q = "QRBN"; *q; q++) n = add(out, n, from, to, *q, target);
+                } else {
+                    n = add(out, n, from, to, 0, target);
+                }
+                if (df == 0 && rank == (white ? 1 : 6) && p->sq[to + 8 * forward] == '.')
+                    n = add(out, n, from, to + 8 * forward, 0, target);
+            }
+            break;
+        }
+        case 'N':
+        case 'K': {
+            const int (*deltas)[2] = type_of(c) == 'N' ? jumps : steps;
+            for (int i = 0; i < 8; i++) {
+                int f = file + deltas[i][0], r = rank + deltas[i][1];
+                if (on_board(f, r) && !own(p->sq[r * 8 + f], white)) n = add(out, n, from, r * 8 + f, 0, target);
+            }
+            if (type_of(c) != 'K' || from != (white ? 4 : 60)) break;
+            char rook = piece_of('R', white);
+            if ((p->castling & (white ? 1 : 4)) && p->sq[from + 1] == '.' && p->sq[from + 2] == '.' &&
+                p->sq[from + 3] == rook && !attacked(p, from, !white) && !attacked(p, from + 1, !white))
+                n = add(out, n, from, from + 2, 0, target);
+            if ((p->castling & (white ? 2 : 8)) && p->sq[from - 1] == '.' && p->sq[from - 2] == '.' &&
+                p->sq[from - 3] == '.' && p->sq[from - 4] == rook && !attacked(p, from, !white) &&
+                !attacked(p, from - 1, !white))
+                n = add(out, n, from, from - 2, 0, target);
+            break;
+        }
+        default:
+            for (int i = 0; i < 8; i++) {
+                if ((type_of(c) == 'B' && i % 2 == 0) || (type_of(c) == 'R' && i % 2 == 1)) continue;
+                int f = file + steps[i][0], r = rank + steps[i][1];
+                for (; on_board(f, r); f += steps[i][0], r += steps[i][1]) {
+                    char there = p->sq[r * 8 + f];
+                    if (own(there, white)) break;
+                    n = add(out, n, from, r * 8 + f, 0, target);
+                    if (there != '.') break;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// the moves of one piece type to one square, what a SAN move asks for. cheaper than generate for
+// the knights and sliders: only whether each of them lines up with the square is looked at
+static int generate_to(const position* p, char type, int target, move* out) {
+    if (type == 'K') return generate(p, type, target, out);
+    if (own(p->sq[target], p->white)) return 0;
+    char piece = piece_of(type, p->white);
+    int n = 0, file = target % 8, rank = target / 8;
+    if (type == 'P') {
+        // the pawns that push or capture onto it, straight from the square
+        int back = p->white ? -8 : 8, last = rank == 0 || rank == 7;
+        if (rank == (p->white ? 0 : 7)) return 0;
+        int from[4], count = 0;
+        if (p->sq[target] == '.') {
+            if (p->sq[target + back] == piece) from[count++] = target + back;
+            else if (p->sq[target + back] == '.' && rank == (p->white ? 3 : 4) && p->sq[target + 2 * back] == piece)
+                from[count++] = target + 2 * back;
+        }
+        if (p->sq[target] != '.' || target == p->ep) {
+            if (file > 0 && p->sq[target + back - 1] == piece) from[count++] = target + back - 1;
+            if (file < 7 && p->sq[target + back + 1] == piece) from[count++] = target + back + 1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (!last) n = add(out, n, from[i], target, 0, -1);
+            else for (const char* q = "QRBN"; *q; q++) n = add(out, n, from[i], target, *q, -1);
+        }
+        return n;
+    }
+    for (int from = 0; from < 64; from++) {
+        if (p->sq[from] != piece) continue;
+        int df = file - from % 8, dr = rank - from / 8;
+        if (type == 'N') {
+            if (abs(df) * abs(dr) == 2) n = add(out, n, from, target, 0, -1);
+            continue;
+        }
+        int straight = (df == 0) != (dr == 0), diagonal = df != 0 && abs(df) == abs(dr);
+        if (!(type == 'R' ? straight : type == 'B' ? diagonal : straight || diagonal)) continue;
+        int step = (dr > 0) - (dr < 0), sideways = (df > 0) - (df < 0);
+        int at = from + step * 8 + sideways;
+        while (at != target && p->sq[at] == '.') at += step * 8 + sideways;
+        if (at == target) n = add(out, n, from, target, 0, -1);
+    }
+    return n;
+}
+
+// castling rights a move from or to this square takes away
+static int rights_kept(int square) {
+    switch (square) {
+    case 0: return ~2;
+    case 4: return ~3;
+    case 7: return ~1;
+    case 56: return ~8;
+    case 60: return ~12;
+    case 63: return ~4;
+    default: return ~0;
+    }
+}
+
+static void make_move(position* p, move m) {
+    char piece = p->sq[m.from];
+    if (type_of(piece) == 'P' && m.to == p->ep && m.from % 8 != m.to % 8)
+        p->sq[m.to + (p->white ? -8 : 8)] = '.';
+    if (type_of(piece) == 'K' && abs(m.to - m.from) == 2) {
+        int rook = m.to > m.from ? m.from + 3 : m.from - 4;
+        p->sq[(m.from + m.to) / 2] = p->sq[rook];
+        p->sq[rook] = '.';
+    }
+    p->sq[m.to] = m.promo ? piece_of(m.promo, p->white) : piece;
+    p->sq[m.from] = '.';
+    p->ep = type_of(piece) == 'P' && abs(m.to - m.from) == 16 ? (m.from + m.to) / 2 : -1;
+    p->castling &= rights_kept(m.from) & rights_kept(m.to);
+    p->white = !p->white;
+}
+
+static int legal(const position* p, move m) {
+    position next = *p;
+    make_move(&next, m);
+    return !in_check(&next, p->white);
+}
+
+static int has_legal_move(const position* p) {
+    move moves[MAX_MOVES];
+    int n = generate(p, 0, -1, moves);
+    for (int i = 0; i < n; i++) {
+        if (legal(p, moves[i])) return 1;
+    }
+    return 0;
+}
+
+// the legal move a SAN token stands for. returns NULL, or why there is none. marker gets the
+// token's own claim: 0 nothing, 1 '+', 2 '#'
+static const char* resolve_san(const position* p, const char* token, size_t len, move* out, int* marker) {
+    char san[16];
+    if (len == 0 || len >= sizeof(san)) return "not a move";
+    memcpy(san, token, len);
+    san[len] = '\0';
+    *marker = 0;
+    while (len > 0 && strchr("+#!?", san[len - 1])) {
+        if (san[len - 1] == '#') *marker = 2;
+        else if (san[len - 1] == '+' && *marker == 0) *marker = 1;
+        san[--len] = '\0';
+    }
+
+    char type = 'P', promo = 0;
+    int from_file = -1, from_rank = -1, to;
+    if (strcmp(san, "O-O") == 0 || strcmp(san, "0-0") == 0 || strcmp(san, "O-O-O") == 0 ||
+        strcmp(san, "0-0-0") == 0) {
+        type = 'K';
+        from_file = 4;
+        from_rank = p->white ? 0 : 7;
+        to = from_rank * 8 + (len == 3 ? 6 : 2);
+    } else {
+        const char* s = san;
+        const char* end = san + len;
+        if (*s && strchr("NBRQK", *s)) type = *s++;
+        if (end - s > 2 && strchr("NBRQ", end[-1])) {
+            promo = *--end;
+            if (end[-1] == '=') end--;
+        }
+        if (end - s < 2 || end[-2] < 'a' || end[-2] > 'h' || end[-1] < '1' || end[-1] > '8') return "not a move";
+        to = (end[-1] - '1') * 8 + end[-2] - 'a';
+        for (; s < end - 2; s++) {
+            if (*s >= 'a' && *s <= 'h') from_file = *s - 'a';
+            else if (*s >= '1' && *s <= '8') from_rank = *s - '1';
+            else if (*s != 'x' && *s != '-' && *s != ':') return "not a move";
+        }
+        if (promo && type != 'P') return "not a move";
+        if (san[0] < 'A' || san[0] > 'Z') {
+            // like python-chess: a square to a square is any piece's move ("g1f3", "e1g1"), and a
+            // pawn without its file only moves along the target's file, so "d5" never captures
+            if (from_file >= 0 && from_rank >= 0) {
+                char piece = p->sq[from_rank * 8 + from_file];
+                if (!own(piece, p->white)) return "illegal";
+                type = type_of(piece);
+            } else if (from_file < 0) {
+                from_file = to % 8;
+            }
+        }
+    }
+
+    move moves[MAX_MOVES];
+    int n = generate_to(p, type, to, moves), found = 0;
+    for (int i = 0; i < n; i++) {
+        if (from_file >= 0 && moves[i].from % 8 != from_file) continue;
+        if (from_rank >= 0 && moves[i].from / 8 != from_rank) continue;
+        if (moves[i].promo != promo || !legal(p, moves[i])) continue;
+        if (found++ == 0) *out = moves[i];
+    }
+    if (found > 1) return "ambiguous";
+    if (found == 0) return type == 'P' && !promo && (to / 8 == 0 || to / 8 == 7) ? "missing promotion" : "illegal";
+    return NULL;
+}
+
+// ---- games ----
+
+static int strict;           // --strict: every '+' and '#' has to match the position
+
+static int is_result(const char* token, size_t len) {
+    return (len == 3 && (memcmp(token, "1-0", 3) == 0 || memcmp(token, "0-1", 3) == 0)) ||
+           (len == 7 && memcmp(token, "1/2-1/2", 7) == 0) || (len == 1 && *token == '*');
+}
+
+// replay a game's movetext from the start position. returns the plies played; at the first
+// problem it stops and writes it to error (which stays "" otherwise). with history, the position
+// after every ply is kept there as well ((*history)[0] is the start), the caller frees it
+static int replay(const char* pgn, size_t len, position** history, char* error, size_t error_size) {
+    position p;
+    start_position(&p);
+    int plies = 0, capacity = 0;
+    error[0] = '\0';
+    if (history) {
+        capacity = 128;
+        *history = malloc(capacity * sizeof(position));
+        (*history)[0] = p;
+    }
+
+    int line_start = 1;
+    for (size_t i = 0; i < len;) {
+        char c = pgn[i];
+        if (c == '\n') {
+            line_start = 1;
+            i++;
+            continue;
+        }
+        if (isspace((unsigned char)c)) {
+            i++;
+            continue;
+        }
+        if (line_start && (c == '[' || c == '%')) {
+            // a tag pair, or an escaped line
+            if (c == '[' && plies == 0 && len - i > 5 && memcmp(pgn + i, "[FEN ", 5) == 0) {
+                snprintf(error, error_size, "starts from a FEN position, not supported");
+                return plies;
+            }
+            while (i < len && pgn[i] != '\n') i++;
+            continue;
+        }
+        line_start = 0;
+        if (c == '{') {
+            while (i < len && pgn[i] != '}') i++;
+            i++;
+            continue;
+        }
+        if (c == ';') {
+            while (i < len && pgn[i] != '\n') i++;
+            continue;
+        }
+        if (c == '(') {
+            // a variation, with its own comments and variations
+            int depth = 0;
+            for (; i < len; i++) {
+                if (pgn[i] == '{') {
+                    while (i < len && pgn[i] != '}') i++;
+                } else if (pgn[i] == '(') {
+                    depth++;
+                } else if (pgn[i] == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            i++;
+            continue;
+        }
+        if (c == ')') {
+            i++;
+            continue;
+        }
+        if (c == '$') {
+            for (i++; i < len && isdigit((unsigned char)pgn[i]); i++);
+            continue;
+        }
+
+        size_t start = i;
+        while (i < len && !isspace((unsigned char)pgn[i]) && !strchr("{}();$", pgn[i])) i++;
+        const char* token = pgn + start;
+        size_t length = i - start;
+        if (is_result(token, length)) break;
+        // "12.", "12...", "12.e4"
+        size_t skip = 0;
+        while (skip < length && isdigit((unsigned char)token[skip])) skip++;
+        while (skip < length && token[skip] == '.') skip++;
+        if (skip == length) continue;
+        token += skip;
+        length -= skip;
+
+        move m;
+        int marker, number = plies / 2 + 1;
+        const char* dots = p.white ? "." : "...";
+        const char* problem = resolve_san(&p, token, length, &m, &marker);
+        if (problem) {
+            snprintf(error, error_size, "move %d%s %.*s: %s", number, dots, (int)length, token, problem);
+            return plies;
+        }
+        make_move(&p, m);
+        plies++;
+        if (history) {
+            if (plies == capacity) {
+                capacity *= 2;
+                *history = realloc(*history, capacity * sizeof(position));
+            }
+            (*history)[plies] = p;
+        }
+
+        // python-chess doesn't look at the '+' and '#', old databases often have '+' for a mate
+        if (!strict) continue;
+        int expected = 0;
+        if (in_check(&p, p.white)) expected = has_legal_move(&p) ? 1 : 2;
+        if (marker != expected) {
+            static const char* const names[] = {"no mark", "'+'", "'#'"};
+            snprintf(error, error_size, "move %d%s %.*s: marked %s but the position says %s", number, dots,
+                     (int)length, token, names[marker], names[expected]);
+            return plies;
+        }
+    }
+    return plies;
+}
+
+// ---- what chess_sim.py prints ----
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} text;
+
+static void text_printf(text* t, const char* format, ...) {
+    va_list args;
+    while (1) {
+        va_start(args, format);
+        int n = vsnprintf(t->data + t->len, t->capacity - t->len, format, args);
+        va_end(args);
+        if (n < 0) return;
+        if (t->len + n < t->capacity) {
+            t->len += n;
+            return;
+        }
+        t->capacity = (t->len + n + 1) * 2;
+        t->data = realloc(t->data, t->capacity);
+    }
+}
+
+typedef struct {
+    char key[64];
+    char value[256];
+} tag;
+
+// python-chess's headers: the seven tag roster first, in its order and with its defaults, then
+// the other tags as they come. a repeated tag keeps its place and takes the last value
+static void render_headers(text* out, const char* pgn, size_t len) {
+    static const char* const roster[7] = {"Event", "Site", "Date", "Round", "White", "Black", "Result"};
+    static const char* const defaults[7] = {"?", "?", "????.??.??", "?", "?", "?", "*"};
+    tag tags[7 + MAX_TAGS];
+    int count = 7;
+    for (int i = 0; i < 7; i++) {
+        snprintf(tags[i].key, sizeof(tags[i].key), "%s", roster[i]);
+        snprintf(tags[i].value, sizeof(tags[i].value), "%s", defaults[i]);
+    }
+
+    for (size_t i = 0; i < len;) {
+        size_t end = i;
+        while (end < len && pgn[end] != '\n') end++;
+        const char* line = pgn + i;
+        size_t length = end - i;
+        i = end + 1;
+        while (length > 0 && isspace((unsigned char)line[length - 1])) length--;
+        if (length == 0) continue;
+        if (line[0] != '[') break;
+        const char* open = memchr(line, '"', length);
+        if (length < 4 || line[length - 1] != ']' || line[length - 2] != '"' || !open || open >= line + length - 2) continue;
+
+        char key[64], value[256];
+        size_t k = 0, v = 0;
+        for (const char* s = line + 1; s < open && !isspace((unsigned char)*s) && k + 1 < sizeof(key); s++) key[k++] = *s;
+        key[k] = '\0';
+        for (const char* s = open + 1; s < line + length - 2 && v + 1 < sizeof(value); s++) {
+            if (*s == '\\' && (s[1] == '"' || s[1] == '\\')) s++;
+            value[v++] = *s;
+        }
+        value[v] = '\0';
+
+        int at = 0;
+        while (at < count && strcmp(tags[at].key, key) != 0) at++;
+        if (at == count) {
+            if (count == 7 + MAX_TAGS) continue;
+            count++;
+        }
+        memcpy(tags[at].key, key, k + 1);
+        memcpy(tags[at].value, value, v + 1);
+    }
+
+    text_printf(out, "Metadata from PGN file:\n");
+    for (int i = 0; i < count; i++) text_printf(out, "[%s \"%s\"]\n", tags[i].key, tags[i].value);
+}
+
+static void render_board(text* out, const position* p, int current, int total) {
+    text_printf(out, "Move %d/%d\n  a b c d e f g h\n", current, total);
+    for (int rank = 7; rank >= 0; rank--) {
+        text_printf(out, "%d ", rank + 1);
+        for (int file = 0; file < 8; file++) text_printf(out, "%c ", p->sq[rank * 8 + file]);
+        text_printf(out, "%d\n", rank + 1);
+    }
+    text_printf(out, "  a b c d e f g h\n");
+}
+
+// chess_sim.py's output for the keys, one key a line like tester.sh feeds them. when the keys run
+// out before a 'q' it ends at the prompt, where chess_sim.py would die on EOF
+static void render_session(text* out, const char* pgn, size_t len, const char* keys) {
+    static const char* const prompt =
+        "Press 'd' to move forward, 'a' to move back, 'w' to go to the start, 's' to go to the end, 'q' to quit: ";
+    position* history;
+    char error[128];
+    int total = replay(pgn, len, &history, error, sizeof(error));
+    int current = 0;
+
+    render_headers(out, pgn, len);
+    render_board(out, &history[0], 0, total);
+    for (const char* k = keys;; k++) {
+        text_printf(out, "%s", prompt);
+        if (*k == '\0') break;
+        char key = isspace((unsigned char)*k) ? '\0' : tolower((unsigned char)*k);
+        if (key == 'q') {
+            text_printf(out, "Exiting.\nEnd of game.\n");
+            break;
+        }
+        if (key == 'd' && current == total) {
+            text_printf(out, "No more moves available.\n");
+            continue;
+        }
+        if (key == 'd') current++;
+        else if (key == 'a' && current > 0) current--;
+        else if (key == 'w') current = 0;
+        else if (key == 's') current = total;
+        if (key == 'd' || key == 'a' || key == 'w' || key == 's') render_board(out, &history[current], current, total);
+        else text_printf(out, "Invalid key pressed: %.*s\n", key != '\0', &key);
+    }
+    free(history);
+}
+
+// ---- loading ----
+
+typedef struct {
+    const char* database;    // where the games came from
+    char dir[PATH_MAX];      // split_pgn.sh's output
+    char base[256];          // its files are <dir>/<base>_<n>.pgn
+    int games;
+    int matched, missing, different, extra;
+    int status;              // split_pgn.sh's exit status, -1 if it couldn't run
+    int temporary;           // dir is ours, removed at the end
+} split_check;
+
+enum { SPLIT_UNCHECKED, SPLIT_MATCH, SPLIT_MISSING, SPLIT_DIFFERENT };
+
+typedef struct {
+    const char* text;
+    size_t len;
+    const char* source;      // the file it was loaded from
+    int number;              // its place in that file, from 1
+    split_check* split;      // set when split_pgn.sh's file for it is checked as well
+    int plies;
+    int split_status;
+    char* error;
+} game;
+
+static game* games;
+static int game_count, game_capacity;
+static int threads;
+
+static char* load_file(const char* path, size_t* len) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    char* data = malloc(st.st_size + 1);
+    size_t done = 0;
+    while (data && done < (size_t)st.st_size) {
+        ssize_t n = read(fd, data + done, st.st_size - done);
+        if (n <= 0) break;
+        done += n;
+    }
+    close(fd);
+    if (!data) return NULL;
+    data[done] = '\0';
+    *len = done;
+    return data;
+}
+
+// split like split_pgn.sh should: a game starts at every Event tag (not at an EventDate tag)
+static int add_games(const char* source, const char* data, size_t len, split_check* split) {
+    int number = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= len;) {
+        size_t end = i;
+        while (end < len && data[end] != '\n') end++;
+        int boundary = i == len || (len - i > 6 && memcmp(data + i, "[Event", 6) == 0 && isspace((unsigned char)data[i + 6]));
+        if (boundary && i > start) {
+            if (game_count == game_capacity) {
+                game_capacity = game_capacity ? game_capacity * 2 : 1024;
+                games = realloc(games, game_capacity * sizeof(game));
+            }
+            games[game_count++] = (game){.text = data + start, .len = i - start, .source = source,
+                                         .number = ++number, .split = split};
+            start = i;
+        }
+        if (i == len) break;
+        i = end < len ? end + 1 : len;
+    }
+    return number;
+}
+
+static int pgn_name(const struct dirent* e) {
+    size_t n = strlen(e->d_name);
+    return n > 4 && strcmp(e->d_name + n - 4, ".pgn") == 0;
+}
+
+static int pgn_or_dir(const struct dirent* e) {
+    return pgn_name(e) || (e->d_type == DT_DIR && e->d_name[0] != '.');
+}
+
+// a .pgn file (one game or a whole database) or a directory tree of them
+static int load_path(const char* path) {
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        size_t len;
+        char* data = load_file(path, &len);
+        if (!data) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        add_games(path, data, len, NULL);
+        return 0;
+    }
+
+    struct dirent** list;
+    int n = scandir(path, &list, pgn_or_dir, versionsort);
+    if (n < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        char* file;
+        if (asprintf(&file, "%s/%s", path, list[i]->d_name) >= 0 && load_path(file) < 0) return -1;
+        free(list[i]);
+    }
+    free(list);
+    return 0;
+}
+
+// ---- comparing like tester.sh ----
+
+// tester.sh's preprocess_file drops the blank lines at the start and the whitespace at the end
+static void normalize(const char** data, size_t* len) {
+    const char* s = *data;
+    const char* end = s + *len;
+    for (const char* line = s; line < end;) {
+        const char* p = line;
+        while (p < end && *p != '\n' && isspace((unsigned char)*p)) p++;
+        if (p < end && *p != '\n') break;
+        line = s = p < end ? p + 1 : end;
+    }
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *data = s;
+    *len = end - s;
+}
+
+static int same_text(const char* a, size_t a_len, const char* b, size_t b_len) {
+    normalize(&a, &a_len);
+    normalize(&b, &b_len);
+    return a_len == b_len && memcmp(a, b, a_len) == 0;
+}
+
+static void check_split(game* g) {
+    char path[PATH_MAX + 300];
+    snprintf(path, sizeof(path), "%s/%s_%d.pgn", g->split->dir, g->split->base, g->number);
+    size_t len;
+    char* data = load_file(path, &len);
+    if (!data) {
+        g->split_status = SPLIT_MISSING;
+        return;
+    }
+    g->split_status = same_text(g->text, g->len, data, len) ? SPLIT_MATCH : SPLIT_DIFFERENT;
+    free(data);
+}
+
+// files of split_pgn.sh past the last game
+static int count_extra(const split_check* split) {
+    struct dirent** list;
+    int n = scandir(split->dir, &list, pgn_name, NULL), extra = 0;
+    size_t base = strlen(split->base);
+    for (int i = 0; i < n; i++) {
+        const char* name = list[i]->d_name;
+        if (strncmp(name, split->base, base) == 0 && name[base] == '_' && atoi(name + base + 1) > split->games) extra++;
+        free(list[i]);
+    }
+    if (n >= 0) free(list);
+    return extra;
+}
+
+// ---- the thread pool ----
+
+typedef struct {
+    int count;
+    int next;
+    void (*job)(int index);
+} pool;
+
+static void* pool_worker(void* arg) {
+    pool* work = arg;
+    int first;
+    while ((first = __atomic_fetch_add(&work->next, BATCH, __ATOMIC_RELAXED)) < work->count) {
+        for (int i = first; i < first + BATCH && i < work->count; i++) work->job(i);
+    }
+    return NULL;
+}
+
+static void run_parallel(int count, void (*job)(int index)) {
+    pool work = {count, 0, job};
+    int n = threads < (count + BATCH - 1) / BATCH ? threads : (count + BATCH - 1) / BATCH;
+    pthread_t workers[n > 0 ? n : 1];
+    int started = 0;
+    for (; started < n - 1; started++) {
+        if (pthread_create(&workers[started], NULL, pool_worker, &work) != 0) break;
+    }
+    pool_worker(&work);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+}
+
+static void check_game(int index) {
+    game* g = &games[index];
+    char error[160];
+    g->plies = replay(g->text, g->len, NULL, error, sizeof(error));
+    if (error[0]) g->error = strdup(error);
+    if (g->split) check_split(g);
+}
+
+// ---- tests_config.json ----
+
+typedef struct {
+    const char* section;     // "part_2" or "part_2_special"
+    int number;              // in its section, from 1
+    char* pgn;               // as the config has it, relative to the config's directory
+    char* keys;
+    int passed;
+    char problem[128];
+} sim_test;
+
+static char config_dir[PATH_MAX];
+static char sim_script[PATH_MAX * 3];
+static sim_test* sim_tests;
+static int sim_count;
+
+// the next string literal of a JSON text, or NULL at its end
+static char* next_string(const char** at) {
+    const char* s = strchr(*at, '"');
+    if (!s) return NULL;
+    const char* end = ++s;
+    while (*end && *end != '"') end += *end == '\\' && end[1] ? 2 : 1;
+    *at = *end ? end + 1 : end;
+    return strndup(s, end - s);
+}
+
+// everything tester.sh reads from it is a flat string, a scan over them is enough
+typedef struct {
+    char* input;
+    char* expected;
+} split_test;
+
+static int read_config(const char* path, split_test** splits, int* split_count) {
+    size_t len;
+    char* data = load_file(path, &len);
+    if (!data) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    const char* at = data;
+    const char* section = "";
+    char *input = NULL, *pgn = NULL;
+    for (char* s; (s = next_string(&at));) {
+        char* value = NULL;
+        if (strcmp(s, "part_1") == 0 || strcmp(s, "part_2") == 0 || strcmp(s, "part_2_special") == 0) {
+            section = strcmp(s, "part_1") == 0 ? "part_1" : strcmp(s, "part_2") == 0 ? "part_2" : "part_2_special";
+        } else if (strcmp(s, "input") == 0) {
+            input = next_string(&at);
+        } else if (strcmp(s, "expected_output_directory") == 0 && input && (value = next_string(&at))) {
+            *splits = realloc(*splits, (*split_count + 1) * sizeof(split_test));
+            (*splits)[(*split_count)++] = (split_test){input, value};
+            input = NULL;
+        } else if (strcmp(s, "input_path_pgn") == 0) {
+            pgn = next_string(&at);
+        } else if (strcmp(s, "moves") == 0 && pgn && (value = next_string(&at))) {
+            int number = 1;
+            for (int i = 0; i < sim_count; i++) number += sim_tests[i].section == section;
+            sim_tests = realloc(sim_tests, (sim_count + 1) * sizeof(sim_test));
+            sim_tests[sim_count++] = (sim_test){.section = section, .number = number, .pgn = pgn, .keys = value};
+            pgn = NULL;
+        }
+        free(s);
+    }
+    free(data);
+    return 0;
+}
+
+// run a script with bash from the config's directory, like tester.sh. stdin from in_fd and
+// stdout + stderr to out_fd (-1: /dev/null). returns its exit status, -1 if it didn't run
+static int run_script(const char* script, const char* arg1, const char* arg2, int in_fd, int out_fd) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addchdir_np(&actions, config_dir);
+    if (in_fd >= 0) posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    if (out_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, out_fd, STDERR_FILENO);
+    } else {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+    char* argv[] = {"bash", (char*)script, (char*)arg1, (char*)arg2, NULL};
+    pid_t pid;
+    int err = posix_spawn(&pid, "/bin/bash", &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    int st;
+    if (err != 0 || waitpid(pid, &st, 0) < 0) return -1;
+    return WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+}
+
+static int temp_fd(void) {
+    char name[] = "/tmp/chess_check.XXXXXX";
+    int fd = mkstemp(name);
+    if (fd >= 0) unlink(name);
+    return fd;
+}
+
+// keep both outputs under fails/ like tester.sh does
+static void save_failure(const sim_test* t, const char* student, size_t student_len, const text* expected) {
+    char dir[PATH_MAX + 64], path[PATH_MAX + 128];
+    snprintf(dir, sizeof(dir), "%s/fails", config_dir);
+    mkdir(dir, 0777);
+    snprintf(dir, sizeof(dir), "%s/fails/test_%s%d", config_dir, strcmp(t->section, "part_2") ? "special_" : "",
+             t->number);
+    mkdir(dir, 0777);
+    const char* names[] = {"student_output.txt", "expected_output.txt"};
+    const char* data[] = {student, expected->data};
+    size_t lens[] = {student_len, expected->len};
+    for (int i = 0; i < 2; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        FILE* f = fopen(path, "w");
+        if (!f) continue;
+        fwrite(data[i], 1, lens[i], f);
+        fclose(f);
+    }
+}
+
+static void check_sim(int index) {
+    sim_test* t = &sim_tests[index];
+    char path[PATH_MAX * 2];
+    snprintf(path, sizeof(path), "%s/%s", config_dir, t->pgn);
+    size_t len;
+    char* pgn = load_file(path, &len);
+    if (!pgn) {
+        snprintf(t->problem, sizeof(t->problem), "%s: %s", t->pgn, strerror(errno));
+        return;
+    }
+    text expected = {0};
+    render_session(&expected, pgn, len, t->keys);
+    free(pgn);
+
+    // the keys one a line, what tester.sh's echo -e "$MOVES_WITH_ENTER" writes
+    int in = temp_fd(), out = temp_fd();
+    size_t keys = strlen(t->keys);
+    char* lines = malloc(keys * 2 + 1);
+    for (size_t i = 0; i < keys; i++) {
+        lines[i * 2] = t->keys[i];
+        lines[i * 2 + 1] = '\n';
+    }
+    int ok = in >= 0 && out >= 0 && lines && write(in, lines, keys * 2) == (ssize_t)(keys * 2) &&
+             lseek(in, 0, SEEK_SET) == 0;
+    free(lines);
+    if (!ok || run_script(sim_script, t->pgn, NULL, in, out) < 0) {
+        snprintf(t->problem, sizeof(t->problem), "couldn't run chess_sim.sh");
+    } else {
+        off_t size = lseek(out, 0, SEEK_END);
+        char* student = malloc(size + 1);
+        size_t got = size > 0 ? pread(out, student, size, 0) : 0;
+        if (got == expected.len && memcmp(student, expected.data, got) == 0) {
+            t->passed = 1;
+        } else {
+            int line = 1;
+            for (size_t i = 0; i < got && i < expected.len && student[i] == expected.data[i]; i++) line += student[i] == '\n';
+            snprintf(t->problem, sizeof(t->problem), "differs from line %d", line);
+            save_failure(t, student, got, &expected);
+        }
+        free(student);
+    }
+    if (in >= 0) close(in);
+    if (out >= 0) close(out);
+    free(expected.data);
+}
+
+// ---- main ----
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void set_base(split_check* split, const char* database) {
+    const char* slash = strrchr(database, '/');
+    snprintf(split->base, sizeof(split->base), "%s", slash ? slash + 1 : database);
+    size_t n = strlen(split->base);
+    if (n > 4 && strcmp(split->base + n - 4, ".pgn") == 0) split->base[n - 4] = '\0';
+}
+
+static void remove_dir(const char* dir) {
+    struct dirent** list;
+    int n = scandir(dir, &list, NULL, NULL);
+    for (int i = 0; i < n; i++) {
+        char path[PATH_MAX + 300];
+        snprintf(path, sizeof(path), "%s/%s", dir, list[i]->d_name);
+        if (strcmp(list[i]->d_name, ".") && strcmp(list[i]->d_name, "..")) unlink(path);
+        free(list[i]);
+    }
+    if (n >= 0) free(list);
+    rmdir(dir);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [-j threads] [--strict] [--split <database.pgn> <dir>]... [--config <tests_config.json> [--scripts <dir>]] "
+            "[pgn files or directories...]\n"
+            "       %s --show <game.pgn> <keys>\n",
+            name, name);
+}
+
+int main(int argc, char* argv[]) {
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* config = NULL;
+    const char* scripts = NULL;
+    split_check* splits = NULL;
+    int split_count = 0;
+    const char** paths = malloc(argc * sizeof(char*));
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--split") == 0 && i + 2 < argc) {
+            splits = realloc(splits, (split_count + 1) * sizeof(split_check));
+            split_check* split = &splits[split_count++];
+            *split = (split_check){.database = argv[i + 1]};
+            snprintf(split->dir, sizeof(split->dir), "%s", argv[i + 2]);
+            set_base(split, argv[i + 1]);
+            i += 2;
+        } else if (strcmp(argv[i], "--strict") == 0) {
+            strict = 1;
+        } else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config = argv[++i];
+        } else if (strcmp(argv[i], "--scripts") == 0 && i + 1 < argc) {
+            scripts = argv[++i];
+        } else if (strcmp(argv[i], "--show") == 0 && i + 2 < argc) {
+            size_t len;
+            char* pgn = load_file(argv[i + 1], &len);
+            if (!pgn) {
+                fprintf(stderr, "%s: %s\n", argv[i + 1], strerror(errno));
+                return 1;
+            }
+            text out = {0};
+            render_session(&out, pgn, len, argv[i + 2]);
+            fwrite(out.data, 1, out.len, stdout);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            paths[path_count++] = argv[i];
+        }
+    }
+    if (threads < 1 || (path_count == 0 && split_count == 0 && !config)) {
+        usage(argv[0]);
+        return 1;
+    }
+    double start = now_seconds();
+
+    // the config's paths are relative to its directory, and its scripts live one up (tester.sh's cd ..)
+    split_test* config_splits = NULL;
+    int config_split_count = 0;
+    if (config) {
+        char resolved[PATH_MAX];
+        if (!realpath(config, resolved) || read_config(resolved, &config_splits, &config_split_count) < 0) {
+            fprintf(stderr, "%s: %s\n", config, strerror(errno));
+            return 1;
+        }
+        *strrchr(resolved, '/') = '\0';
+        snprintf(config_dir, sizeof(config_dir), "%s", resolved);
+        char script_dir[PATH_MAX * 2];
+        snprintf(script_dir, sizeof(script_dir), "%s/%s", config_dir, "..");
+        if (scripts && !realpath(scripts, script_dir)) {
+            fprintf(stderr, "%s: %s\n", scripts, strerror(errno));
+            return 1;
+        }
+
+        char split_script[PATH_MAX * 3];
+        snprintf(split_script, sizeof(split_script), "%s/split_pgn.sh", script_dir);
+        if (access(split_script, R_OK) != 0) snprintf(split_script, sizeof(split_script), "%s/pgn_split.sh", script_dir);
+        snprintf(sim_script, sizeof(sim_script), "%s/chess_sim.sh", script_dir);
+
+        // split_pgn.sh once per database, into a directory of our own
+        for (int i = 0; i < config_split_count; i++) {
+            splits = realloc(splits, (split_count + 1) * sizeof(split_check));
+            split_check* split = &splits[split_count++];
+            *split = (split_check){.database = config_splits[i].input, .temporary = 1};
+            snprintf(split->dir, sizeof(split->dir), "/tmp/chess_check.XXXXXX");
+            set_base(split, config_splits[i].input);
+            split->status = mkdtemp(split->dir) ? run_script(split_script, config_splits[i].input, split->dir, -1, -1) : -1;
+        }
+    }
+
+    for (int i = 0; i < path_count; i++) {
+        if (load_path(paths[i]) < 0) return 1;
+    }
+    for (int i = 0; i < split_count; i++) {
+        char path[PATH_MAX * 2];
+        const char* database = splits[i].database;
+        if (config && i >= split_count - config_split_count && database[0] != '/') {
+            snprintf(path, sizeof(path), "%s/%s", config_dir, database);
+            database = strdup(path);
+        }
+        size_t len;
+        char* data = load_file(database, &len);
+        if (!data) {
+            fprintf(stderr, "%s: %s\n", database, strerror(errno));
+            return 1;
+        }
+        splits[i].games = add_games(splits[i].database, data, len, &splits[i]);
+    }
+    double loaded = now_seconds();
+
+    run_parallel(game_count, check_game);
+    run_parallel(sim_count, check_sim);
+    double done = now_seconds();
+
+    int failed = 0, shown = 0;
+    long long plies = 0;
+    for (int i = 0; i < game_count; i++) {
+        game* g = &games[i];
+        plies += g->plies;
+        if (g->split_status == SPLIT_MATCH) g->split->matched++;
+        else if (g->split_status == SPLIT_MISSING) g->split->missing++;
+        else if (g->split_status == SPLIT_DIFFERENT) g->split->different++;
+        if (g->split_status == SPLIT_MISSING || g->split_status == SPLIT_DIFFERENT) {
+            if (shown++ < MAX_SHOWN)
+                printf("%s/%s_%d.pgn: %s\n", g->split->dir, g->split->base, g->number,
+                       g->split_status == SPLIT_MISSING ? "missing" : "differs from the database");
+        }
+        if (!g->error) continue;
+        failed++;
+        if (shown++ < MAX_SHOWN) printf("%s game %d: %s\n", g->source, g->number, g->error);
+    }
+    if (shown > MAX_SHOWN) printf("... %d more\n", shown - MAX_SHOWN);
+
+    int passed = 1;
+    for (int i = 0; i < split_count; i++) {
+        split_check* split = &splits[i];
+        split->extra = count_extra(split);
+        int ok = split->status == 0 && split->matched == split->games && split->extra == 0;
+        passed &= ok;
+        printf("split %s -> %s:", split->database, split->temporary ? "split_pgn.sh" : split->dir);
+        if (split->status != 0) printf(" exit status %d,", split->status);
+        printf(" %d games, %d match, %d missing, %d different, %d extra%s\n", split->games, split->matched,
+               split->missing, split->different, split->extra, ok ? "" : "  FAILED");
+        if (split->temporary) remove_dir(split->dir);
+    }
+    for (int i = 0; i < sim_count; i++) {
+        sim_test* t = &sim_tests[i];
+        passed &= t->passed;
+        printf("%s test %d (%s, %s): %s\n", t->section, t->number, t->pgn, t->keys, t->passed ? "ok" : t->problem);
+    }
+
+    printf("replayed %d games (%lld plies) on %d thread(s): %d ok, %d failed. load %.3fs, check %.3fs\n",
+           game_count, plies, threads, game_count - failed, failed, loaded - start, done - loaded);
+    return passed && failed == 0 ? 0 : 1;
+}
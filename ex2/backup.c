@@ -8,6 +8,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <limits.h>
+#include "../common/os_instrument.h"
 
 #define PATH_BUFFER 4096
 
@@ -20,7 +21,10 @@ void backup_item(const char *src_path, const char *dst_path);
 // A regular file → Creates a hard link in the backup location
 void create_hard_link(const char *src, const char *dst) {
     // make a hard link by 'link' function
-    if (link(src, dst) == -1) {
+    unsigned long long t = os_instrument_begin();
+    int linked = link(src, dst);
+    os_instrument_end(OS_LINK, t);
+    if (linked == -1) {
         perror("Error creating hard link");
         exit(EXIT_FAILURE);
     }
@@ -31,6 +35,7 @@ void copy_symlink(const char *src, const char *dst) {
     // get a buffer to maintain the path of the original linkd file
     char link_holds[PATH_BUFFER];
     // get the path of the original linkd file
+    unsigned long long t = os_instrument_begin();
     ssize_t len = readlink(src, link_holds, sizeof(link_holds) - 1);
     
     if (len == -1) {
@@ -41,7 +46,9 @@ void copy_symlink(const char *src, const char *dst) {
     link_holds[len] = '\0';
     
     // make a soft limk to the original linkd file
-    if (symlink(link_holds, dst) == -1) {
+    int linked = symlink(link_holds, dst);
+    os_instrument_end(OS_LINK, t);
+    if (linked == -1) {
         perror("Error creating symbolic link");
         exit(EXIT_FAILURE);
     }
@@ -51,7 +58,10 @@ void copy_symlink(const char *src, const char *dst) {
 void copy_directory(const char *src, const char *dst) {
     struct stat st;
     // check that is a directory by structer stat
-    if (stat(src, &st) == -1) {
+    unsigned long long t = os_instrument_begin();
+    int found = stat(src, &st);
+    os_instrument_end(OS_STAT, t);
+    if (found == -1) {
         perror("Error getting directory stats");
         exit(EXIT_FAILURE);
     }
@@ -68,7 +78,10 @@ void backup_item(const char *src_path, const char *dst_path) {
     struct stat st;
     
     // Get information about the source file/directory
-    if (lstat(src_path, &st) == -1) {
+    unsigned long long t = os_instrument_begin();
+    int found = lstat(src_path, &st);
+    os_instrument_end(OS_STAT, t);
+    if (found == -1) {
         perror("Error getting file stats");
         exit(EXIT_FAILURE);
     }
@@ -81,7 +94,9 @@ void backup_item(const char *src_path, const char *dst_path) {
         // Symbolic link - replicate the link
         copy_symlink(src_path, dst_path);
     } else if (S_ISDIR(st.st_mode)) {
-        // Directory - create the directory and process contents
+        // Directory - create the directory and process contents. the copy probe times all of
+        // it, so a directory's row includes the directories inside it
+        unsigned long long copy = os_instrument_begin();
         copy_directory(src_path, dst_path);
         
         // Open the directory
@@ -113,6 +128,7 @@ void backup_item(const char *src_path, const char *dst_path) {
         }
         
         closedir(dir);
+        os_instrument_end(OS_COPY, copy);
     } else {
         // Other file types (devices, sockets, etc.) - not handled
         fprintf(stderr, "Unsupported file type: %s\n", src_path);
@@ -0,0 +1,159 @@
+#ifndef BATTLE_LOG_H
+#define BATTLE_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// the tournament sets this so its gladiators log binary records instead of text
+#define BINARY_LOG_ENV "GLADIATOR_BINARY_LOG"
+#define BATTLE_LOG_MAGIC 0x474f4c47u // "GLOG"
+
+// one hit: who hit us, how hard, and what was left
+typedef struct {
+    int32_t opponent;
+    int32_t damage;
+    int32_t health;
+} battle_record;
+
+// first page of G<id>_log.bin, the records start at dataOffset
+typedef struct {
+    uint32_t magic;
+    int32_t pid;
+    int32_t gladiatorID;
+    uint32_t dataOffset;
+    uint64_t count;
+} battle_log_header;
+
+// the writer maps a window of the file (a page worth of records = 12 pages) and fills it
+// with plain stores; when it is full the window moves on to the next part of the file
+typedef struct {
+    int fd;
+    battle_record* window;
+    uint32_t windowRecords;
+    uint32_t used;
+    uint64_t windowStart;   // index of window[0] in the whole log
+    uint32_t dataOffset;
+    int32_t pid;
+    int32_t gladiatorID;
+} battle_log;
+
+static inline int battle_log_map_window(battle_log* log) {
+    off_t windowBytes = (off_t)log->windowRecords * sizeof(battle_record);
+    off_t start = log->dataOffset + (off_t)log->windowStart * sizeof(battle_record);
+    if (ftruncate(log->fd, start + windowBytes) < 0) return -1;
+    log->window = mmap(NULL, windowBytes, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, start);
+    if (log->window == MAP_FAILED) {
+        log->window = NULL;
+        return -1;
+    }
+    log->used = 0;
+    return 0;
+}
+
+static inline int battle_log_open(battle_log* log, const char* path, int gladiatorID) {
+    long page = sysconf(_SC_PAGESIZE);
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (log->fd < 0) return -1;
+    log->windowRecords = page;
+    log->windowStart = 0;
+    log->dataOffset = page;
+    log->pid = getpid();
+    log->gladiatorID = gladiatorID;
+    if (battle_log_map_window(log) < 0) {
+        close(log->fd);
+        return -1;
+    }
+    return 0;
+}
+
+// slow path of battle_log_append: the window is full, map the next one. if that fails the
+// log has no window left and keeps counting only the records of the full ones
+static inline int battle_log_advance(battle_log* log) {
+    munmap(log->window, (size_t)log->windowRecords * sizeof(battle_record));
+    log->windowStart += log->windowRecords;
+    log->used = 0;
+    return battle_log_map_window(log);
+}
+
+// -1 once the next window couldn't be mapped: this record and every later one are lost
+static inline int battle_log_append(battle_log* log, int opponent, int damage, int health) {
+    if (!log->window || (log->used == log->windowRecords && battle_log_advance(log) < 0)) return -1;
+    battle_record* record = &log->window[log->used++];
+    record->opponent = opponent;
+    record->damage = damage;
+    record->health = health;
+    return 0;
+}
+
+// write the header and cut the file to the records actually written. -1 if some were lost too
+static inline int battle_log_close(battle_log* log) {
+    battle_log_header header = {BATTLE_LOG_MAGIC, log->pid, log->gladiatorID, log->dataOffset,
+                                log->windowStart + log->used};
+    int result = 0;
+    if (log->window) {
+        munmap(log->window, (size_t)log->windowRecords * sizeof(battle_record));
+    } else {
+        result = -1;
+    }
+    if (pwrite(log->fd, &header, sizeof(header), 0) != sizeof(header) ||
+        ftruncate(log->fd, log->dataOffset + header.count * sizeof(battle_record)) < 0) {
+        result = -1;
+    }
+    close(log->fd);
+    return result;
+}
+
+// the text of one hit, as the gladiator used to write it
+static inline void battle_log_print(FILE* out, int opponent, int damage, int health) {
+    fprintf(out, "Facing opponent %d... Taking %d damage\n", opponent, damage);
+    if (health > 0) {
+        fprintf(out, "Are you not entertained? Remaining health: %d\n", health);
+    } else {
+        fprintf(out, "The gladiator has fallen... Final health: %d\n", health);
+    }
+}
+
+// turn G<id>_log.bin back into the text log, byte for byte what the gladiator used to write
+static inline int render_battle_log(const char* binPath, const char* textPath) {
+    int fd = open(binPath, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(battle_log_header)) {
+        close(fd);
+        return -1;
+    }
+    const char* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    const battle_log_header* header = (const battle_log_header*)data;
+    if (header->magic != BATTLE_LOG_MAGIC || header->dataOffset > (uint64_t)st.st_size ||
+        header->count > (st.st_size - header->dataOffset) / sizeof(battle_record)) {
+        munmap((void*)data, st.st_size);
+        return -1;
+    }
+
+    FILE* out = fopen(textPath, "w");
+    if (!out) {
+        munmap((void*)data, st.st_size);
+        return -1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 16);
+
+    const battle_record* records = (const battle_record*)(data + header->dataOffset);
+    fprintf(out, "Gladiator process started. %d:\n", header->pid);
+    for (uint64_t i = 0; i < header->count; i++) {
+        battle_log_print(out, records[i].opponent, records[i].damage, records[i].health);
+    }
+
+    int result = fclose(out) == 0 ? 0 : -1;
+    munmap((void*)data, st.st_size);
+    return result;
+}
+
+#endif
@@ -1,26 +1,104 @@
+#define _FILE_OFFSET_BITS 64
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 
-#define MAX_LINE 1024
+#define IO_CHUNK (1 << 20)
 #define READ_RESULT_FILE "read_results.txt"
+#define LATENCY_LOG_ENV "FILE_PROCESSOR_LATENCY_LOG"
 
-void process_read(int dataFileDescriptor, int resultFileDescriptor, int start, int end) {
+// one shared buffer for every chunked copy, so big ranges never need a big malloc
+static char io_buffer[IO_CHUNK];
+
+// when the benchmark asks for it, the time of every R/W request in ns (uint64) goes here
+static FILE* latency_log = NULL;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// cursor over the mmap'd requests file, the parser never copies a line out of it
+typedef struct {
+    const char* pos;
+    const char* end;
+} request_cursor;
+
+// write the whole buffer even if the kernel takes it in parts
+static int write_all(int fd, const char* buf, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t n = (offset < 0) ? write(fd, buf, len) : pwrite(fd, buf, len, offset);
+        if (n <= 0) return -1;
+        buf += n;
+        len -= n;
+        if (offset >= 0) offset += n;
+    }
+    return 0;
+}
+
+// skip spaces and tabs but never the end of the line
+static void skip_blanks(request_cursor* c) {
+    while (c->pos < c->end && (*c->pos == ' ' || *c->pos == '\t')) {
+        c->pos++;
+    }
+}
+
+// move the cursor to the first byte of the next line
+static void skip_line(request_cursor* c) {
+    const char* nl = memchr(c->pos, '\n', c->end - c->pos);
+    c->pos = nl ? nl + 1 : c->end;
+}
+
+// parse a signed 64-bit decimal number, returns 1 on success
+static int parse_offset(request_cursor* c, off_t* out) {
+    skip_blanks(c);
+    int negative = 0;
+    if (c->pos < c->end && (*c->pos == '-' || *c->pos == '+')) {
+        negative = (*c->pos == '-');
+        c->pos++;
+    }
+    if (c->pos >= c->end || *c->pos < '0' || *c->pos > '9') {
+        return 0;
+    }
+    unsigned long long value = 0;
+    while (c->pos < c->end && *c->pos >= '0' && *c->pos <= '9') {
+        unsigned long long digit = *c->pos - '0';
+        // checked before it's added, value * 10 could wrap around otherwise
+        if (value > ((unsigned long long)INT64_MAX - digit) / 10) return 0; // does not fit in off_t
+        value = value * 10 + digit;
+        c->pos++;
+    }
+    *out = negative ? -(off_t)value : (off_t)value;
+    return 1;
+}
+
+// copy [from, to] of the data file into the results file in chunks,
+// so the size of the read is not limited by memory
+static void copy_range(int dataFileDescriptor, int resultFileDescriptor, off_t from, off_t to) {
+    while (from <= to) {
+        size_t len = (to - from + 1 < IO_CHUNK) ? (size_t)(to - from + 1) : IO_CHUNK;
+        ssize_t n = pread(dataFileDescriptor, io_buffer, len, from);
+        if (n <= 0) break;
+        write_all(resultFileDescriptor, io_buffer, n, -1);
+        from += n;
+    }
+}
+
+void process_read(int dataFileDescriptor, int resultFileDescriptor, off_t start, off_t end) {
     // check if the range is valid
     if (start < 0 || end < start) {
         return;
     }
 
-    // define the length of the data and allocate buffer
-    int len = end - start + 1;
-    char* buffer = (char*)malloc(len);
-    if (!buffer) return;
-
     off_t file_size = lseek(dataFileDescriptor, 0, SEEK_END);
     if (start >= file_size) {
-        free(buffer);
         return;
     }
 
@@ -28,41 +106,197 @@ void process_read(int dataFileDescriptor, int resultFileDescriptor, int start, i
         end = file_size - 1;
     }
 
-    len = end - start + 1;
+    copy_range(dataFileDescriptor, resultFileDescriptor, start, end);
+    write(resultFileDescriptor, "\n", 1);
+}
+
+// every committed W is one version: the insert it made and the file size after it.
+// version 0 is the file as it was opened, writes only insert, so every byte of an
+// old version is still in the data file and an old read only has to know where it moved to
+typedef struct {
+    off_t offset;
+    off_t length;
+    off_t size;
+} version_entry;
+
+typedef struct {
+    version_entry* entries;
+    long count;
+    long capacity;
+} version_log;
+
+// a piece of an old read, [start, end) in the coordinates of the newest version seen so far
+typedef struct {
+    off_t start;
+    off_t end;
+} read_piece;
+
+static int add_version(version_log* log, off_t offset, off_t length) {
+    if (log->count == log->capacity) {
+        long capacity = log->capacity ? log->capacity * 2 : 64;
+        version_entry* entries = realloc(log->entries, capacity * sizeof(version_entry));
+        if (!entries) return -1;
+        log->entries = entries;
+        log->capacity = capacity;
+    }
+    off_t size = log->count ? log->entries[log->count - 1].size : 0;
+    log->entries[log->count].offset = offset;
+    log->entries[log->count].length = length;
+    log->entries[log->count].size = size + length;
+    log->count++;
+    return 0;
+}
+
+// a committed write without its entry would shift every later R@v, so the run stops there
+static void record_version(version_log* log, off_t offset, off_t length) {
+    if (add_version(log, offset, length) < 0) {
+        perror("malloc");
+        exit(1);
+    }
+}
+
+// read [start, end] as the file looked right after version v
+void process_versioned_read(int dataFileDescriptor, int resultFileDescriptor, version_log* log,
+                            long version, off_t start, off_t end) {
+    // check if the range and the version are valid
+    if (start < 0 || end < start || version < 0 || version >= log->count) {
+        return;
+    }
 
-    lseek(dataFileDescriptor, start, SEEK_SET); // seek to start
-    read(dataFileDescriptor, buffer, len); // read bytesinto the buffer
-    write(resultFileDescriptor, buffer, len); // write the content
+    off_t file_size = log->entries[version].size;
+    if (start >= file_size) {
+        return;
+    }
+
+    if (end >= file_size) {
+        end = file_size - 1;
+    }
+
+    // walk the range forward through every later insert; an insert before a piece
+    // shifts it, an insert inside a piece splits it in two around the new bytes
+    long later = log->count - 1 - version;
+    read_piece* pieces = malloc((later + 1) * sizeof(read_piece));
+    if (!pieces) return;
+    long count = 1;
+    pieces[0].start = start;
+    pieces[0].end = end + 1;
+
+    for (long v = version + 1; v < log->count; v++) {
+        off_t offset = log->entries[v].offset;
+        off_t length = log->entries[v].length;
+        long i = 0;
+        while (i < count && pieces[i].end <= offset) {
+            i++;
+        }
+        if (i < count && pieces[i].start < offset) {
+            memmove(&pieces[i + 1], &pieces[i], (count - i) * sizeof(read_piece));
+            pieces[i].end = offset;
+            pieces[i + 1].start = offset;
+            count++;
+            i++;
+        }
+        for (; i < count; i++) {
+            pieces[i].start += length;
+            pieces[i].end += length;
+        }
+    }
+
+    for (long i = 0; i < count; i++) {
+        copy_range(dataFileDescriptor, resultFileDescriptor, pieces[i].start, pieces[i].end - 1);
+    }
     write(resultFileDescriptor, "\n", 1);
-    free(buffer);
+    free(pieces);
 }
 
-void process_write(int dataFileDescriptor, int offset, char* text) {
+// returns 0 if the text was inserted, -1 if the request was skipped
+int process_write(int dataFileDescriptor, off_t offset, const char* text, size_t text_len) {
     // check if the range is valid
     if (offset < 0 || !text) {
-        return;
+        return -1;
     }
-    // Gets the file size & ensures the offset is within the file.
-    int text_len = strlen(text);
 
+    // Gets the file size & ensures the offset is within the file.
     off_t file_size = lseek(dataFileDescriptor, 0, SEEK_END);
     if (offset > file_size) {
-        return;
+        return -1;
     }
 
-    // define & allocate memory for the data that will be pushed
-    int tail_len = file_size - offset;
-    char* tail = (char*)malloc(tail_len);
-    if (!tail) return;
+    // push the tail forward from its end backwards, one chunk at a time,
+    // so the moved bytes are never overwritten before they are copied
+    off_t tail_end = file_size;
+    while (tail_end > offset) {
+        size_t len = (tail_end - offset < IO_CHUNK) ? (size_t)(tail_end - offset) : IO_CHUNK;
+        off_t from = tail_end - len;
+        if (pread(dataFileDescriptor, io_buffer, len, from) != (ssize_t)len) return -1;
+        if (write_all(dataFileDescriptor, io_buffer, len, from + text_len) < 0) return -1;
+        tail_end = from;
+    }
 
-    lseek(dataFileDescriptor, offset, SEEK_SET); // 
-    read(dataFileDescriptor, tail, tail_len); // read the tail 
+    // the text goes straight from the requests mapping into the data file
+    return write_all(dataFileDescriptor, text, text_len, offset);
+}
 
-    lseek(dataFileDescriptor, offset, SEEK_SET);
-    write(dataFileDescriptor, text, text_len);
-    write(dataFileDescriptor, tail, tail_len);
+// W <offset> <text>      - text is the next word, like before
+// W <offset> #<len> ...  - the <len> bytes after the single separator are the payload, as is
+// returns 1 when the cursor is already at the start of the next line (a payload that ends with
+// '\n', or "#0" with '\n' as the separator), 0 when the rest of the line still has to be skipped
+static int handle_write_request(request_cursor* c, int dataFileDescriptor, version_log* log) {
+    off_t offset;
+    if (!parse_offset(c, &offset)) return 0;
+    skip_blanks(c);
+
+    if (c->pos < c->end && *c->pos == '#') {
+        request_cursor length_cursor = { c->pos + 1, c->end };
+        off_t len;
+        if (parse_offset(&length_cursor, &len) && len >= 0 && length_cursor.pos < c->end &&
+            (*length_cursor.pos == ' ' || *length_cursor.pos == '\n')) {
+            const char* payload = length_cursor.pos + 1;
+            if (len > c->end - payload) {
+                // the payload is cut off, nothing after it can be trusted
+                c->pos = c->end;
+                return 1;
+            }
+            if (process_write(dataFileDescriptor, offset, payload, len) == 0) {
+                record_version(log, offset, len);
+            }
+            c->pos = payload + len;
+            return c->pos == c->end || c->pos[-1] == '\n';
+        }
+    }
 
-    free(tail);
+    const char* text = c->pos;
+    while (c->pos < c->end && *c->pos != ' ' && *c->pos != '\t' &&
+           *c->pos != '\n' && *c->pos != '\r') {
+        c->pos++;
+    }
+    if (c->pos > text && process_write(dataFileDescriptor, offset, text, c->pos - text) == 0) {
+        record_version(log, offset, c->pos - text);
+    }
+    return 0;
+}
+
+// a requests file that can't be mapped (a pipe, /dev/stdin): read all of it into one buffer,
+// so the parser walks it like the mapping. returns NULL on a read or malloc error
+static char* read_requests_stream(int fd, size_t* size) {
+    size_t capacity = IO_CHUNK, used = 0;
+    char* buffer = malloc(capacity);
+    while (buffer) {
+        if (used == capacity) {
+            char* grown = realloc(buffer, capacity * 2);
+            if (!grown) break;
+            buffer = grown;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, buffer + used, capacity - used);
+        if (n == 0) {
+            *size = used;
+            return buffer;
+        }
+        if (n < 0) break;
+        used += n;
+    }
+    free(buffer);
+    return NULL;
 }
 
 int main(int argc, char* argv[]) {
@@ -96,42 +330,95 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
-    FILE* req_file = fdopen(requestFileDescriptor, "r"); // open and convert into file*
-    if (!req_file) {
-        perror("fdopen");
+    // map the whole requests file, the kernel pages it in as the parser walks forward.
+    // a pipe or another stream is read into memory instead
+    struct stat st;
+    if (fstat(requestFileDescriptor, &st) < 0) {
+        perror("fstat");
         close(dataFileDescriptor);
         close(resultFileDescriptor);
+        close(requestFileDescriptor);
+        exit(1);
+    }
+    char* requests = NULL;
+    size_t requestsSize = S_ISREG(st.st_mode) ? (size_t)st.st_size : 0;
+    if (!S_ISREG(st.st_mode)) {
+        requests = read_requests_stream(requestFileDescriptor, &requestsSize);
+        if (!requests) {
+            perror(argv[2]);
+            close(dataFileDescriptor);
+            close(resultFileDescriptor);
+            close(requestFileDescriptor);
+            exit(1);
+        }
+    } else if (requestsSize > 0) {
+        requests = mmap(NULL, requestsSize, PROT_READ, MAP_PRIVATE, requestFileDescriptor, 0);
+        if (requests == MAP_FAILED) {
+            perror("mmap");
+            close(dataFileDescriptor);
+            close(resultFileDescriptor);
+            close(requestFileDescriptor);
+            exit(1);
+        }
+        madvise(requests, requestsSize, MADV_SEQUENTIAL);
+    }
+
+    // version 0 is the data file as it is now
+    version_log log = { NULL, 0, 0 };
+    if (add_version(&log, 0, lseek(dataFileDescriptor, 0, SEEK_END)) < 0) {
+        perror("malloc");
         exit(1);
     }
 
-    // define a line to contain the data
-    char line[MAX_LINE];
-    // as long as we can extract data the loop will run
-    while (fgets(line, sizeof(line), req_file)) {
+    const char* latency_path = getenv(LATENCY_LOG_ENV);
+    if (latency_path && *latency_path) {
+        latency_log = fopen(latency_path, "w");
+        if (!latency_log) perror(latency_path);
+    }
+
+    request_cursor c = { requests, requests + requestsSize };
+    // as long as there are lines left the loop will run
+    while (c.pos < c.end) {
+        char command = *c.pos;
+        int lineDone = 0;
+        uint64_t started = latency_log ? now_ns() : 0;
         // Q = quit: quit from the loop
-        if (line[0] == 'Q') {
+        if (command == 'Q') {
             break;
         }
-        // R = read: read data for the line
-        else if (line[0] == 'R') {
-            // creat a varaibles to offset
-            int start, end;
-            // read from string and insert by patterns
-            if (sscanf(line, "R %d %d", &start, &end) == 2) { 
-                process_read(dataFileDescriptor, resultFileDescriptor, start, end);
+        // R = read: read data for the line, R@v reads it as it was after version v
+        else if (command == 'R') {
+            c.pos++;
+            off_t version = -1, start, end;
+            if (c.pos < c.end && *c.pos == '@') {
+                c.pos++;
+                if (!parse_offset(&c, &version) || version < 0) version = log.count;
             }
-        // W = write: write data into the file
-        } else if (line[0] == 'W') {
-            int offset;
-            char text[MAX_LINE];
-            if (sscanf(line, "W %d %s", &offset, text) == 2) {
-                process_write(dataFileDescriptor, offset, text);
+            if (parse_offset(&c, &start) && parse_offset(&c, &end)) {
+                if (version < 0) {
+                    process_read(dataFileDescriptor, resultFileDescriptor, start, end);
+                } else {
+                    process_versioned_read(dataFileDescriptor, resultFileDescriptor, &log, version, start, end);
+                }
             }
+        // W = write: write data into the file
+        } else if (command == 'W') {
+            c.pos++;
+            lineDone = handle_write_request(&c, dataFileDescriptor, &log);
+        }
+        if (latency_log && (command == 'R' || command == 'W')) {
+            uint64_t took = now_ns() - started;
+            fwrite(&took, sizeof(took), 1, latency_log);
         }
+        if (!lineDone) skip_line(&c);
     }
 
+    if (latency_log) fclose(latency_log);
+    free(log.entries);
+    if (!S_ISREG(st.st_mode)) free(requests);
+    else if (requests) munmap(requests, requestsSize);
     close(dataFileDescriptor);
     close(resultFileDescriptor);
-    fclose(req_file);
+    close(requestFileDescriptor);
     return 0;
 }
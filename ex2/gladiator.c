@@ -2,88 +2,90 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include "gladiator_stats.h"
+#include "battle_log.h"
 
-#define MAX_LINE 256
-#define NUM_OPPONENTS 3
+// stats of every gladiator, loaded once by the tournament (NULL if we run on our own)
+static const stats_table* statsTable = NULL;
+// log binary records into G<id>_log.bin, the tournament renders the text later
+static int binaryLog = 0;
 
 // function that get the power of the opponent to use it by the battle
 int getOpponentattackPower(int opponentID) {
-    char opponentFile[20]; // buffer of the name
-    snprintf(opponentFile, sizeof(opponentFile), "G%d.txt", opponentID);
-
-    // open opponent's file
-    FILE* f = fopen(opponentFile, "r");
-    if (!f) return 0;
-
-    // get the stats line from the file
-    char line[MAX_LINE];
-    if (!fgets(line, sizeof(line), f)) {
-        fclose(f);
-        return 0;
+    // one array load when the tournament shared its table
+    if (statsTable && opponentID >= 0 && opponentID < statsTable->count) {
+        return statsTable->stats[opponentID].attackPower;
     }
-    fclose(f);
 
-    int health, attackPowerPower;
-    sscanf(line, "%d, %d", &health, &attackPowerPower);
-    return attackPowerPower;
+    // otherwise read the opponent's file
+    gladiator_stats opponent;
+    if (read_gladiator_file(opponentID, &opponent, NULL, 0) < 0) return 0;
+    return opponent.attackPower;
 }
 
-
-int main(int argc, char* argv[]) {
-    // if their is no enough arguments
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <gladiator_id>\n", argv[0]);
-        return 1;
-    }
-
-    // convert from char to int
-    int gladiatorID = atoi(argv[1]);
-
-
-    char statFile[20];
-    snprintf(statFile, sizeof(statFile), "G%d.txt", gladiatorID);
-
-    // open file with a permission of read
-    FILE* f = fopen(statFile, "r");
-    if (!f) {
+// the whole battle of one gladiator, used by the gladiator process and by the
+// tournament's thread and pool modes. returns the number of hits taken, -1 on error
+int run_gladiator(int gladiatorID) {
+    gladiator_stats stats;
+    // array of opponents
+    int opponents[MAX_OPPONENTS];
+    int numOpponents = read_gladiator_file(gladiatorID, &stats, opponents, MAX_OPPONENTS);
+    if (numOpponents < 0) {
         perror("Failed to open stat file");
-        return 1;
+        return -1;
     }
-
-
-    // get the line of the stat 
-    char line[MAX_LINE];
-    if (!fgets(line, sizeof(line), f)) {
-        perror("Failed to read line");
-        fclose(f);
-        return 1;
+    if (numOpponents == 0) {
+        fprintf(stderr, "G%d.txt has no opponents\n", gladiatorID);
+        return -1;
+    }
+    int health = stats.health;
+
+    // binary log: a few stores per hit, no formatting
+    if (binaryLog) {
+        char binFile[32];
+        snprintf(binFile, sizeof(binFile), "G%d_log.bin", gladiatorID);
+        battle_log blog;
+        if (battle_log_open(&blog, binFile, gladiatorID) < 0) {
+            perror("Failed to create log file");
+            return -1;
+        }
+        int hits = 0, lost = 0;
+        while (health > 0 && !lost) {
+            for (int i = 0; i < numOpponents && health > 0 && !lost; i++) {
+                int damage = getOpponentattackPower(opponents[i]);
+                health -= damage;
+                hits++;
+                // no room for the hit in the log: stop, the log can't be completed anyway
+                lost = battle_log_append(&blog, opponents[i], damage, health) < 0;
+            }
+        }
+        if (battle_log_close(&blog) < 0 || lost) {
+            perror("Failed to write log file");
+            return -1;
+        }
+        return hits;
     }
-    fclose(f);
-
-    int health, attackPower;
-    // array of opponents
-    int opponents[NUM_OPPONENTS];
-    // insert the stats to veraibles.
-    sscanf(line, "%d, %d, %d, %d, %d", &health, &attackPower, &opponents[0], &opponents[1], &opponents[2]);
 
     // log file part
-    char logFile[30];
+    char logFile[32];
     snprintf(logFile, sizeof(logFile), "G%d_log.txt", gladiatorID);
     FILE* log = fopen(logFile, "w");
     if (!log) {
         perror("Failed to create log file");
-        return 1;
+        return -1;
     }
 
     // write the opening line into the log file
     fprintf(log, "Gladiator process started. %d:\n", getpid());
 
     // loop from README
+    int hits = 0;
     while (health > 0) {
-        for (int i = 0; i < NUM_OPPONENTS; i++) {
+        for (int i = 0; i < numOpponents; i++) {
             int opponent_attackPowerPowerPower = getOpponentattackPower(opponents[i]);
             fprintf(log, "Facing opponent %d... Taking %d damage\n", opponents[i], opponent_attackPowerPowerPower);
             health -= opponent_attackPowerPowerPower;
+            hits++;
             if (health > 0) {
                 fprintf(log, "Are you not entertained? Remaining health: %d\n", health);
             } else {
@@ -94,5 +96,99 @@ int main(int argc, char* argv[]) {
     }
 
     fclose(log);
+    return hits;
+}
+
+// closed form of run_gladiator's loop, without fighting: the damage after k hits is
+// c*S + P[j] (c full rounds of the opponents, S their total attack, P[j] the first j of them),
+// so the gladiator falls in the first round c where c*S + max(P) >= health, at the first j
+// that gets there. returns the number of hits, -1 if it never falls
+int predict_hits(int gladiatorID) {
+    gladiator_stats stats;
+    int opponents[MAX_OPPONENTS];
+    int numOpponents = read_gladiator_file(gladiatorID, &stats, opponents, MAX_OPPONENTS);
+    if (numOpponents <= 0) return -1;
+    if (stats.health <= 0) return 0;
+
+    long long prefix[MAX_OPPONENTS];
+    long long sum = 0, maxPrefix = 0;
+    for (int i = 0; i < numOpponents; i++) {
+        sum += getOpponentattackPower(opponents[i]);
+        prefix[i] = sum;
+        if (i == 0 || sum > maxPrefix) maxPrefix = sum;
+    }
+
+    long long health = stats.health;
+    long long rounds = 0;
+    if (maxPrefix < health) {
+        if (sum <= 0) return -1; // every round heals at least as much as it hurts
+        rounds = (health - maxPrefix + sum - 1) / sum;
+    }
+    for (int i = 0; i < numOpponents; i++) {
+        if (rounds * sum + prefix[i] >= health) {
+            return (int)(rounds * numOpponents + i + 1);
+        }
+    }
+    return -1;
+}
+
+// --predict --logs: G<id>_log.txt straight from the closed form, hit k is opponent k % n and
+// leaves health - (k / n) * S - P[k % n], so nothing is fought. hits is predict_hits' answer
+int write_predicted_log(int gladiatorID, int hits) {
+    gladiator_stats stats;
+    int opponents[MAX_OPPONENTS];
+    int numOpponents = read_gladiator_file(gladiatorID, &stats, opponents, MAX_OPPONENTS);
+    if (numOpponents <= 0 || hits < 0) return -1;
+
+    int damage[MAX_OPPONENTS];
+    long long prefix[MAX_OPPONENTS];
+    long long sum = 0;
+    for (int i = 0; i < numOpponents; i++) {
+        damage[i] = getOpponentattackPower(opponents[i]);
+        sum += damage[i];
+        prefix[i] = sum;
+    }
+
+    char logFile[32];
+    snprintf(logFile, sizeof(logFile), "G%d_log.txt", gladiatorID);
+    FILE* log = fopen(logFile, "w");
+    if (!log) return -1;
+    setvbuf(log, NULL, _IOFBF, 1 << 16);
+    fprintf(log, "Gladiator process started. %d:\n", getpid());
+    for (int k = 0; k < hits; k++) {
+        int i = k % numOpponents;
+        long long health = stats.health - (long long)(k / numOpponents) * sum - prefix[i];
+        battle_log_print(log, opponents[i], damage[i], (int)health);
+    }
+    return fclose(log) == 0 ? 0 : -1;
+}
+
+// the gladiator process; also a subcommand of the multicall binary, so it's compiled in
+// with the tournament too
+int gladiator_main(int argc, char* argv[]) {
+    // if their is no enough arguments
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <gladiator_id>\n", argv[0]);
+        return 1;
+    }
+
+    // convert from char to int
+    int gladiatorID = atoi(argv[1]);
+    statsTable = attach_stats_table();
+    binaryLog = getenv(BINARY_LOG_ENV) != NULL;
+
+    int hits = run_gladiator(gladiatorID);
+    if (hits < 0) {
+        return 1;
+    }
+
+    // tell the tournament how long we lasted, for its deterministic mode
+    report_hits(gladiatorID, hits);
     return 0;
-}
\ No newline at end of file
+}
+
+#ifndef GLADIATOR_NO_MAIN
+int main(int argc, char* argv[]) {
+    return gladiator_main(argc, argv);
+}
+#endif
@@ -0,0 +1,96 @@
+#ifndef GLADIATOR_STATS_H
+#define GLADIATOR_STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STATS_LINE 4096
+#define MAX_OPPONENTS 64
+// the tournament leaves the stats table open on this fd for the gladiators it runs
+#define STATS_FD_ENV "GLADIATOR_STATS_FD"
+// and, in its deterministic mode, an int per id where each gladiator writes its number of hits
+#define RESULTS_FD_ENV "GLADIATOR_RESULTS_FD"
+// ids above this are looked up in their file instead of growing the table
+#define MAX_TABLE_ID (1 << 24)
+
+// the stats of one gladiator as written in G<id>.txt
+typedef struct {
+    int health;
+    int attackPower;
+} gladiator_stats;
+
+// read-only table shared by all gladiators, stats[id] is the gladiator of G<id>.txt
+// (a gladiator without a file has attack power 0, like a failed fopen)
+typedef struct {
+    int count;
+    gladiator_stats stats[];
+} stats_table;
+
+// parse G<id>.txt: "health, attack, opponent1, opponent2, ..."
+// returns the number of opponents written into opponents (up to max_opponents), -1 if the file can't be read
+static inline int read_gladiator_file(int id, gladiator_stats* out, int* opponents, int max_opponents) {
+    char statFile[32];
+    snprintf(statFile, sizeof(statFile), "G%d.txt", id);
+
+    FILE* f = fopen(statFile, "r");
+    if (!f) return -1;
+
+    char line[STATS_LINE];
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    char* pos = line;
+    char* next;
+    out->health = strtol(pos, &next, 10);
+    pos = (*next == ',') ? next + 1 : next;
+    out->attackPower = strtol(pos, &next, 10);
+
+    int count = 0;
+    while (count < max_opponents) {
+        pos = next;
+        while (*pos == ',' || *pos == ' ') pos++;
+        int opponent = strtol(pos, &next, 10);
+        if (next == pos) break;
+        opponents[count++] = opponent;
+    }
+    return count;
+}
+
+static inline size_t stats_table_size(int count) {
+    return sizeof(stats_table) + (size_t)count * sizeof(gladiator_stats);
+}
+
+// map the table the tournament handed down, NULL when running on our own
+static inline const stats_table* attach_stats_table(void) {
+    const char* fd_text = getenv(STATS_FD_ENV);
+    if (!fd_text) return NULL;
+
+    int fd = atoi(fd_text);
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(stats_table)) return NULL;
+
+    const stats_table* table = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (table == MAP_FAILED) return NULL;
+    if ((size_t)st.st_size < stats_table_size(table->count)) {
+        munmap((void*)table, st.st_size);
+        return NULL;
+    }
+    return table;
+}
+
+// write our number of hits into the tournament's results table, if it asked for it
+static inline void report_hits(int id, int hits) {
+    const char* fd_text = getenv(RESULTS_FD_ENV);
+    if (!fd_text || id < 0 || id >= MAX_TABLE_ID) return;
+    pwrite(atoi(fd_text), &hits, sizeof(hits), (off_t)id * sizeof(hits));
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "battle_log.h"
+
+// turn binary gladiator logs back into the text logs:
+//   ./render_log G1_log.bin            -> G1_log.txt
+//   ./render_log G1_log.bin out.txt
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s <G<id>_log.bin> [output_file]\n", argv[0]);
+        return 1;
+    }
+
+    char textPath[4096];
+    if (argc == 3) {
+        snprintf(textPath, sizeof(textPath), "%s", argv[2]);
+    } else {
+        // G1_log.bin -> G1_log.txt
+        snprintf(textPath, sizeof(textPath), "%s", argv[1]);
+        char* dot = strrchr(textPath, '.');
+        if (!dot || strcmp(dot, ".bin") != 0 || dot - textPath + 5 > (long)sizeof(textPath)) {
+            fprintf(stderr, "%s: expected a .bin file or an output name\n", argv[1]);
+            return 1;
+        }
+        strcpy(dot, ".txt");
+    }
+
+    if (render_battle_log(argv[1], textPath) < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+import argparse
+import os
+import random
+
+# writes G1.txt ... G<n>.txt and roster.txt for big tournaments:
+#   python3 gen_roster.py 10000 big && cd big && ../tournament -r roster.txt -m pool -s
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate gladiator stats files and a roster')
+    parser.add_argument('count', type=int)
+    parser.add_argument('out_dir')
+    parser.add_argument('--opponents', type=int, default=3)
+    parser.add_argument('--health', default='1000:5000')
+    parser.add_argument('--attack', default='50:150')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    health = [int(x) for x in args.health.split(':')]
+    attack = [int(x) for x in args.attack.split(':')]
+    os.makedirs(args.out_dir, exist_ok=True)
+
+    with open(os.path.join(args.out_dir, 'roster.txt'), 'w') as roster:
+        for gid in range(1, args.count + 1):
+            others = [o for o in rng.sample(range(1, args.count + 1), min(args.count, args.opponents + 1)) if o != gid]
+            stats = [rng.randint(*health), rng.randint(*attack)] + others[:args.opponents]
+            with open(os.path.join(args.out_dir, f'G{gid}.txt'), 'w') as f:
+                f.write(', '.join(map(str, stats)))
+            roster.write(f'Gladiator{gid}, {gid}\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,200 @@
+import argparse
+import array
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+PROGRAM_NAME = './file_processor'
+LATENCY_LOG_ENV = 'FILE_PROCESSOR_LATENCY_LOG'
+ALPHABET = b'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789'
+
+# name -> (read, versioned read, write) weights
+MIXES = {
+    'read-heavy': (90, 0, 10),
+    'balanced': (50, 0, 50),
+    'insert-heavy': (10, 0, 90),
+    'history': (45, 45, 10),
+}
+
+
+def parse_size(text):
+    """'64K', '10M', '2G' or plain bytes."""
+    units = {'K': 1 << 10, 'M': 1 << 20, 'G': 1 << 30}
+    text = text.strip().upper()
+    if text and text[-1] in units:
+        return int(float(text[:-1]) * units[text[-1]])
+    return int(text)
+
+
+def parse_range(text):
+    """'32' or '8:64' -> (low, high)."""
+    if ':' in text:
+        low, high = text.split(':')
+        return int(low), int(high)
+    return int(text), int(text)
+
+
+def generate_data(path, size, rng):
+    # repeat one random block, writing a multi-GB file has to be I/O bound
+    block = bytes(rng.choice(ALPHABET) for _ in range(min(size, 1 << 20)))
+    with open(path, 'wb') as f:
+        left = size
+        while left > 0:
+            f.write(block[:left])
+            left -= len(block)
+
+
+class Model:
+    """Reference file_processor: the file as a bytearray, plus a full copy per version
+    when the mix has versioned reads (keep those runs small)."""
+
+    def __init__(self, data, keep_versions):
+        self.data = bytearray(data)
+        self.keep_versions = keep_versions
+        self.versions = [bytes(data)]
+        self.results = []
+
+    def read(self, start, end, version=None):
+        src = self.data if version is None else (self.versions[version] if version < len(self.versions) else b'')
+        if start < 0 or end < start or start >= len(src):
+            return
+        self.results.append(bytes(src[start:end + 1]))
+
+    def write(self, offset, payload):
+        if offset < 0 or offset > len(self.data):
+            return
+        self.data[offset:offset] = payload
+        if self.keep_versions:
+            self.versions.append(bytes(self.data))
+
+
+def generate_requests(path, args, data_size, rng, model):
+    read_w, versioned_w, write_w = MIXES[args.mix]
+    low, high = parse_range(args.payload)
+    size = data_size
+    versions = 1
+    cursor = 0
+    moved = 0
+    with open(path, 'wb') as f:
+        for _ in range(args.ops):
+            kind = rng.choices('RVW', weights=(read_w, versioned_w, write_w))[0]
+            if args.offsets == 'sequential':
+                cursor = cursor + high if cursor + high < size else 0
+                offset = cursor
+            else:
+                offset = rng.randint(0, size)
+            if kind == 'W':
+                length = rng.randint(low, high)
+                binary = rng.random() < args.binary
+                if not binary:
+                    # an empty word makes "W off " a line file_processor skips, without a version
+                    length = max(length, 1)
+                payload = bytes(rng.choice(ALPHABET) for _ in range(length))
+                if binary:
+                    payload = payload.replace(b'A', b' ').replace(b'B', b'\n')
+                    f.write(b'W %d #%d %s\n' % (offset, len(payload), payload))
+                else:
+                    f.write(b'W %d %s\n' % (offset, payload))
+                if model:
+                    model.write(offset, payload)
+                moved += len(payload) + (size - offset)  # the payload and the tail it pushes
+                size += len(payload)
+                versions += 1
+            else:
+                end = offset + rng.randint(low, high) - 1
+                if kind == 'V':
+                    version = rng.randrange(versions)
+                    f.write(b'R@%d %d %d\n' % (version, offset, end))
+                    if model:
+                        model.read(offset, end, version)
+                else:
+                    f.write(b'R %d %d\n' % (offset, end))
+                    if model:
+                        model.read(offset, end)
+                moved += max(0, min(end, size - 1) - offset + 1)
+        f.write(b'Q\n')
+    return moved
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * p / 100))]
+
+
+def run_case(args, work_dir):
+    rng = random.Random(args.seed)
+    data_path = os.path.join(work_dir, 'data.txt')
+    requests_path = os.path.join(work_dir, 'requests.txt')
+    latency_path = os.path.join(work_dir, 'latency.bin')
+
+    data_size = parse_size(args.size)
+    generate_data(data_path, data_size, rng)
+    model = None
+    if args.check:
+        with open(data_path, 'rb') as f:
+            model = Model(f.read(), MIXES[args.mix][1] > 0)
+    moved = generate_requests(requests_path, args, data_size, rng, model)
+
+    env = dict(os.environ, **{LATENCY_LOG_ENV: latency_path})
+    program = os.path.abspath(args.program)
+    started = time.perf_counter()
+    subprocess.run([program, 'data.txt', 'requests.txt'], cwd=work_dir, env=env, check=True)
+    elapsed = time.perf_counter() - started
+
+    latencies = array.array('Q')
+    with open(latency_path, 'rb') as f:
+        latencies.frombytes(f.read())
+    latencies = sorted(latencies)
+
+    print(f"mix={args.mix} size={args.size} ops={args.ops} offsets={args.offsets} payload={args.payload}")
+    print(f"  wall time   : {elapsed:.3f} s")
+    print(f"  throughput  : {args.ops / elapsed:,.0f} ops/sec")
+    print(f"  latency p50 : {percentile(latencies, 50) / 1000:.1f} us")
+    print(f"  latency p99 : {percentile(latencies, 99) / 1000:.1f} us")
+    print(f"  bytes moved : {moved:,}")
+
+    if model:
+        with open(data_path, 'rb') as f:
+            data_match = f.read() == bytes(model.data)
+        with open(os.path.join(work_dir, 'read_results.txt'), 'rb') as f:
+            results_match = f.read() == b''.join(r + b'\n' for r in model.results)
+        if data_match and results_match:
+            print("  ✅ output matches the reference model")
+        else:
+            print(f"  ❌ output differs from the reference model (data: {data_match}, reads: {results_match})")
+            return False
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Load generator and benchmark for file_processor')
+    parser.add_argument('--program', default=PROGRAM_NAME)
+    parser.add_argument('--size', default='64K', help='initial data file size, e.g. 4K, 100M, 2G')
+    parser.add_argument('--ops', type=int, default=100000)
+    parser.add_argument('--mix', choices=sorted(MIXES), default='read-heavy')
+    parser.add_argument('--offsets', choices=['random', 'sequential'], default='random')
+    parser.add_argument('--payload', default='8:64', help='payload / read length, N or LOW:HIGH')
+    parser.add_argument('--binary', type=float, default=0.0, help='share of W requests sent as #<len> payloads')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--check', action='store_true', help='diff the output against the reference model')
+    parser.add_argument('--keep', action='store_true', help="don't delete the generated files")
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix='file_processor_bench_')
+    try:
+        ok = run_case(args, work_dir)
+    finally:
+        if args.keep:
+            print(f"  files kept in {work_dir}")
+        else:
+            shutil.rmtree(work_dir)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,52 +1,499 @@
-
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
+#include "../common/os_instrument.h"
+#include "../common/os_spawn.h"
+
+// the gladiator's battle is compiled in too, for the thread and pool modes
+#define GLADIATOR_NO_MAIN
+#include "gladiator.c"
 
 #define NUM_GLADIATORS 4
+#define MAX_NAME 64
+#define THREAD_STACK (64 * 1024)
 
-int main() {
-    // define the array of the gladiators as same as in the README
-    char* gladiator_names[NUM_GLADIATORS] = {"Maximus", "Lucius", "Commodus", "Spartacus"};
-    char* gladiator_ids[NUM_GLADIATORS] = {"1", "2", "3", "4"};
-    // make a pid array
-    pid_t pids[NUM_GLADIATORS];
+typedef enum { SPAWN_PROCESS, SPAWN_THREAD, SPAWN_POOL } spawn_model;
 
-    // fork 4 procceses for every gladiator
-    for (int i = NUM_GLADIATORS - 1; i >= 0; i--) {
-        pid_t pid = fork();
-        if (pid < 0) {
-            perror("fork failed");
-            exit(1);
+typedef struct {
+    char name[MAX_NAME];
+    char id[16];     // as passed on the gladiator's command line
+    int gladiatorID;
+} roster_entry;
+
+// the roster and how each gladiator did, shared by every spawn model
+static roster_entry* roster = NULL;
+static int rosterSize = 0;
+static int* hits = NULL;          // hits taken by roster[i] before falling
+static int lastFinished = -1;     // roster index of the last gladiator to finish
+static int nextTask = 0;          // pool mode: how many gladiators were handed out
+static int nextRender = 0;        // how many binary logs were handed out to render
+static int* predictedHits = NULL; // --predict --logs: write the logs from these instead
+static pthread_mutex_t finishLock = PTHREAD_MUTEX_INITIALIZER;
+
+// load the stats of every gladiator (and of every opponent they face) once into a
+// read-only shared table, and leave it open for the gladiators we exec.
+// returns the fd of the table and its size in *tableCount, -1 if it could not be
+// created (the gladiators fall back to the files)
+int create_stats_table(int count, int* tableCount) {
+    gladiator_stats* stats = calloc(count, sizeof(gladiator_stats));
+    int* opponents = malloc((size_t)count * MAX_OPPONENTS * sizeof(int));
+    int* numOpponents = calloc(count, sizeof(int));
+    if (!stats || !opponents || !numOpponents) {
+        free(stats); free(opponents); free(numOpponents);
+        return -1;
+    }
+
+    // first pass: the roster files, to know how big the table has to be
+    int maxID = 0;
+    for (int i = 0; i < count; i++) {
+        int id = roster[i].gladiatorID;
+        numOpponents[i] = read_gladiator_file(id, &stats[i], &opponents[i * MAX_OPPONENTS], MAX_OPPONENTS);
+        if (id > maxID && id < MAX_TABLE_ID) maxID = id;
+        for (int j = 0; j < numOpponents[i]; j++) {
+            int opponent = opponents[i * MAX_OPPONENTS + j];
+            if (opponent > maxID && opponent < MAX_TABLE_ID) maxID = opponent;
         }
+    }
 
-        // if its a sun procces run a executble file
-        if (pid == 0) {
-            execl("./gladiator", "gladiator", gladiator_ids[i], NULL);
-            perror("exec failed");
-            exit(1);
+    // shm_open + unlink right away: the name never outlives us, the fd is what gets shared
+    char name[64];
+    snprintf(name, sizeof(name), "/gladiator_stats_%d", getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        free(stats); free(opponents); free(numOpponents);
+        return -1;
+    }
+    shm_unlink(name);
+
+    size_t size = stats_table_size(maxID + 1);
+    stats_table* table = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        table = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (table == MAP_FAILED) {
+        perror("stats table");
+        close(fd);
+        free(stats); free(opponents); free(numOpponents);
+        return -1;
+    }
+
+    // ftruncate zeroed it: every gladiator without a file has attack power 0
+    table->count = maxID + 1;
+    char* loaded = calloc(maxID + 1, 1);
+    for (int i = 0; i < count; i++) {
+        int id = roster[i].gladiatorID;
+        if (numOpponents[i] >= 0 && id >= 0 && id <= maxID) {
+            table->stats[id] = stats[i];
+            loaded[id] = 1;
         }
+    }
+    // second pass: opponents that are not in the roster still need their attack power
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < numOpponents[i]; j++) {
+            int opponent = opponents[i * MAX_OPPONENTS + j];
+            if (opponent < 0 || opponent > maxID || loaded[opponent]) continue;
+            gladiator_stats opponentStats;
+            if (read_gladiator_file(opponent, &opponentStats, NULL, 0) >= 0) {
+                table->stats[opponent] = opponentStats;
+            }
+            loaded[opponent] = 1;
+        }
+    }
+    free(loaded);
+    free(stats); free(opponents); free(numOpponents);
+
+    // the threads of this process read the same pages through a read-only view
+    statsTable = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (statsTable == MAP_FAILED) statsTable = NULL;
+    munmap(table, size);
 
-        pids[i] = pid;
+    // shm_open sets close-on-exec, the gladiator processes need the fd across exec
+    fcntl(fd, F_SETFD, 0);
+    char fd_text[16];
+    snprintf(fd_text, sizeof(fd_text), "%d", fd);
+    setenv(STATS_FD_ENV, fd_text, 1);
+    *tableCount = maxID + 1;
+    return fd;
+}
+
+// an int per gladiator id where the gladiator processes write their number of hits
+int create_results_table(int tableCount) {
+    char name[64];
+    snprintf(name, sizeof(name), "/gladiator_results_%d", getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        return -1;
+    }
+    shm_unlink(name);
+    if (ftruncate(fd, (off_t)tableCount * sizeof(int)) < 0) {
+        perror("results table");
+        close(fd);
+        return -1;
     }
+    fcntl(fd, F_SETFD, 0);
+    char fd_text[16];
+    snprintf(fd_text, sizeof(fd_text), "%d", fd);
+    setenv(RESULTS_FD_ENV, fd_text, 1);
+    return fd;
+}
 
-    pid_t last_finished = 0; // this veraible will contain the winner 
+// roster file: one "Name, ID" per line, blank lines and lines starting with '#' are skipped
+int load_roster(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    int capacity = 64;
+    roster = malloc(capacity * sizeof(roster_entry));
+    char line[256];
+    while (roster && fgets(line, sizeof(line), f)) {
+        char name[MAX_NAME];
+        int id;
+        if (line[0] == '#' || sscanf(line, " %63[^, \t\n]%*[, \t]%d", name, &id) != 2) continue;
+        if (rosterSize == capacity) {
+            capacity *= 2;
+            roster_entry* bigger = realloc(roster, capacity * sizeof(roster_entry));
+            if (!bigger) break;
+            roster = bigger;
+        }
+        snprintf(roster[rosterSize].name, MAX_NAME, "%s", name);
+        snprintf(roster[rosterSize].id, sizeof(roster[rosterSize].id), "%d", id);
+        roster[rosterSize].gladiatorID = id;
+        rosterSize++;
+    }
+    fclose(f);
+    return roster ? rosterSize : -1;
+}
+
+// the four gladiators from the README
+void load_default_roster() {
+    char* gladiator_names[NUM_GLADIATORS] = {"Maximus", "Lucius", "Commodus", "Spartacus"};
+    roster = malloc(NUM_GLADIATORS * sizeof(roster_entry));
     for (int i = 0; i < NUM_GLADIATORS; i++) {
+        snprintf(roster[i].name, MAX_NAME, "%s", gladiator_names[i]);
+        snprintf(roster[i].id, sizeof(roster[i].id), "%d", i + 1);
+        roster[i].gladiatorID = i + 1;
+    }
+    rosterSize = NUM_GLADIATORS;
+}
+
+// record that roster[index] is done, the last one to get here is the winner
+void finish_gladiator(int index, int gladiatorHits) {
+    pthread_mutex_lock(&finishLock);
+    hits[index] = gladiatorHits;
+    lastFinished = index;
+    pthread_mutex_unlock(&finishLock);
+}
+
+void* gladiator_thread(void* arg) {
+    int index = (int)(intptr_t)arg;
+    finish_gladiator(index, run_gladiator(roster[index].gladiatorID));
+    return NULL;
+}
+
+// pool mode: every worker keeps taking the next gladiator until none are left,
+// in the same order the processes are spawned (last roster entry first)
+void* pool_worker(void* arg) {
+    (void)arg;
+    while (1) {
+        int task = __atomic_fetch_add(&nextTask, 1, __ATOMIC_RELAXED);
+        if (task >= rosterSize) break;
+        int index = rosterSize - 1 - task;
+        finish_gladiator(index, run_gladiator(roster[index].gladiatorID));
+    }
+    return NULL;
+}
+
+void run_processes(int resultsFD) {
+    // make a pid array
+    pid_t* pids = malloc(rosterSize * sizeof(pid_t));
+
+    // spawn a process for every gladiator
+    for (int i = rosterSize - 1; i >= 0; i--) {
+        char* args[] = {"gladiator", roster[i].id, NULL};
+        pids[i] = os_spawn("./gladiator", args, 0);
+        if (pids[i] < 0) {
+            fprintf(stderr, "spawn failed: %s\n", strerror(errno));
+            exit(1);
+        }
+    }
+
+    pid_t last_finished = 0; // this veraible will contain the winner
+    for (int i = 0; i < rosterSize; i++) {
         int status;
+        unsigned long long t = os_instrument_begin();
         pid_t finished = wait(&status); // get the last procces
+        os_instrument_end(OS_WAIT, t);
         if (finished > 0) {
-            last_finished = finished; 
+            last_finished = finished;
         }
     }
 
     // check who is the last one that still stand
-    for (int i = 0; i < NUM_GLADIATORS; i++) {
+    for (int i = 0; i < rosterSize; i++) {
         if (pids[i] == last_finished) {
-            printf("The gods have spoken, the winner of the tournament is %s!\n", gladiator_names[i]);
-            break;
+            lastFinished = i;
+        }
+        int gladiatorHits = -1;
+        int id = roster[i].gladiatorID;
+        if (resultsFD >= 0 && id >= 0 && id < MAX_TABLE_ID) {
+            pread(resultsFD, &gladiatorHits, sizeof(int), (off_t)id * sizeof(int));
+        }
+        hits[i] = gladiatorHits;
+    }
+    free(pids);
+}
+
+void run_threads(spawn_model model, int workers) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK);
+
+    int count = (model == SPAWN_THREAD) ? rosterSize : workers;
+    pthread_t* threads = malloc(count * sizeof(pthread_t));
+    for (int t = 0; t < count; t++) {
+        int err;
+        unsigned long long start = os_instrument_begin();
+        if (model == SPAWN_THREAD) {
+            // same order as the processes: last roster entry first
+            int index = rosterSize - 1 - t;
+            err = pthread_create(&threads[t], &attr, gladiator_thread, (void*)(intptr_t)index);
+        } else {
+            err = pthread_create(&threads[t], &attr, pool_worker, NULL);
+        }
+        os_instrument_end(OS_SPAWN, start);
+        if (err != 0) {
+            fprintf(stderr, "thread failed: %s\n", strerror(err));
+            exit(1);
+        }
+    }
+    for (int t = 0; t < count; t++) {
+        unsigned long long start = os_instrument_begin();
+        pthread_join(threads[t], NULL);
+        os_instrument_end(OS_WAIT, start);
+    }
+    free(threads);
+    pthread_attr_destroy(&attr);
+}
+
+// turn the binary logs of the battle into the G<id>_log.txt files, or with --predict --logs
+// write them from the predicted hits
+void* render_worker(void* arg) {
+    (void)arg;
+    while (1) {
+        int index = __atomic_fetch_add(&nextRender, 1, __ATOMIC_RELAXED);
+        if (index >= rosterSize) break;
+        if (predictedHits) {
+            unsigned long long t = os_instrument_begin();
+            if (write_predicted_log(roster[index].gladiatorID, predictedHits[index]) < 0) {
+                fprintf(stderr, "G%d_log.txt: %s\n", roster[index].gladiatorID, strerror(errno));
+            }
+            os_instrument_end(OS_WRITE, t);
+            continue;
+        }
+        char binFile[32], logFile[32];
+        snprintf(binFile, sizeof(binFile), "G%d_log.bin", roster[index].gladiatorID);
+        snprintf(logFile, sizeof(logFile), "G%d_log.txt", roster[index].gladiatorID);
+        unsigned long long t = os_instrument_begin();
+        int rendered = render_battle_log(binFile, logFile);
+        os_instrument_end(OS_WRITE, t);
+        if (rendered == 0) {
+            unlink(binFile);
+        }
+    }
+    return NULL;
+}
+
+void render_logs(int workers) {
+    pthread_t* threads = malloc(workers * sizeof(pthread_t));
+    int started = 0;
+    while (started < workers && pthread_create(&threads[started], NULL, render_worker, NULL) == 0) {
+        started++;
+    }
+    if (started == 0) render_worker(NULL);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+}
+
+// every hit taking the same time, the gladiator with the most hits is the last to
+// finish; on a tie the one spawned later (lower roster index) finishes last
+int deterministic_winner() {
+    int winner = -1;
+    for (int i = 0; i < rosterSize; i++) {
+        if (hits[i] >= 0 && (winner < 0 || hits[i] > hits[winner])) {
+            winner = i;
         }
     }
+    return winner;
+}
+
+void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-r roster_file] [-m process|thread|pool] [-w workers] [-d] [-b] [-s]\n"
+                    "       %s --predict [--logs] [--check] [-r roster_file] [-m ...] [-w workers] [-s]\n", prog, prog);
+    fprintf(stderr, "  -r  one \"Name, ID\" per line (default: the four gladiators of the README)\n");
+    fprintf(stderr, "  -m  run each gladiator as a process (default), a thread, or a task of a worker pool\n");
+    fprintf(stderr, "  -w  number of pool workers (default: number of CPUs)\n");
+    fprintf(stderr, "  -d  deterministic winner: the gladiator that takes the most hits\n");
+    fprintf(stderr, "  -b  keep the binary G<id>_log.bin logs, don't render them (see render_log)\n");
+    fprintf(stderr, "  --predict  compute every gladiator's hits and the -d winner without fighting\n");
+    fprintf(stderr, "  --logs     with --predict: also write the G<id>_log.txt files, from the prediction\n");
+    fprintf(stderr, "  --check    with --predict: also fight with -m in deterministic mode and compare\n");
+    fprintf(stderr, "  -s  print wall-clock time and peak memory to stderr\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* rosterFile = NULL;
+    spawn_model model = SPAWN_PROCESS;
+    int workers = sysconf(_SC_NPROCESSORS_ONLN);
+    int deterministic = 0, showStats = 0, keepBinary = 0;
+    int predict = 0, predictLogs = 0, predictCheck = 0;
+
+    struct option longOptions[] = {
+        {"predict", no_argument, NULL, 'P'},
+        {"logs", no_argument, NULL, 'L'},
+        {"check", no_argument, NULL, 'C'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:m:w:dbsh", longOptions, NULL)) != -1) {
+        switch (opt) {
+            case 'r': rosterFile = optarg; break;
+            case 'm':
+                if (!strcmp(optarg, "process")) model = SPAWN_PROCESS;
+                else if (!strcmp(optarg, "thread")) model = SPAWN_THREAD;
+                else if (!strcmp(optarg, "pool")) model = SPAWN_POOL;
+                else { usage(argv[0]); return 1; }
+                break;
+            case 'w': workers = atoi(optarg); break;
+            case 'd': deterministic = 1; break;
+            case 'b': keepBinary = 1; break;
+            case 's': showStats = 1; break;
+            case 'P': predict = 1; break;
+            case 'L': predictLogs = 1; break;
+            case 'C': predictCheck = 1; break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (workers < 1) workers = 1;
+
+    if (rosterFile) {
+        if (load_roster(rosterFile) <= 0) {
+            fprintf(stderr, "No gladiators in %s\n", rosterFile);
+            return 1;
+        }
+    } else {
+        load_default_roster();
+    }
+    hits = malloc(rosterSize * sizeof(int));
+
+    // every gladiator keeps its log open while it fights
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    // the gladiators only store binary records while they fight, the text comes after
+    binaryLog = 1;
+    setenv(BINARY_LOG_ENV, "1", 1);
+
+    struct timespec started, fought, ended;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    // every stats file is read here once instead of on every hit of every gladiator
+    int tableCount = 0;
+    int statsFD = create_stats_table(rosterSize, &tableCount);
+    int resultsFD = -1;
+
+    // --predict: the outcome straight from the stats, O(opponents) per gladiator
+    int* predicted = NULL;
+    if (predict) {
+        predicted = malloc(rosterSize * sizeof(int));
+        int kept = 0;
+        for (int i = 0; i < rosterSize; i++) {
+            int gladiatorHits = predict_hits(roster[i].gladiatorID);
+            if (gladiatorHits < 0) {
+                // its battle would never end, so it doesn't fight --check's battle either
+                fprintf(stderr, "%s (G%d) never falls, leaving it out\n", roster[i].name, roster[i].gladiatorID);
+                continue;
+            }
+            roster[kept] = roster[i];
+            predicted[kept++] = gladiatorHits;
+        }
+        rosterSize = kept;
+        // --logs alone writes them from the prediction, by a pool of workers
+        if (predictLogs && !predictCheck) predictedHits = predicted;
+        deterministic = 1;
+    }
+
+    int fight = !predict || predictCheck;
+    if (fight && model == SPAWN_PROCESS) {
+        if (deterministic && statsFD >= 0) resultsFD = create_results_table(tableCount);
+        run_processes(resultsFD);
+    } else if (fight) {
+        run_threads(model, workers);
+    }
+    if (statsFD >= 0) close(statsFD);
+    if (resultsFD >= 0) close(resultsFD);
+
+    clock_gettime(CLOCK_MONOTONIC, &fought);
+    if ((fight && !keepBinary) || predictedHits) render_logs(workers);
+    clock_gettime(CLOCK_MONOTONIC, &ended);
+
+    // --check: the prediction has to match the battle, gladiator by gladiator
+    if (predict && predictCheck) {
+        int mismatches = 0;
+        for (int i = 0; i < rosterSize; i++) {
+            if (predicted[i] >= 0 && predicted[i] != hits[i]) {
+                fprintf(stderr, "%s (G%d): predicted %d hits, fought %d\n",
+                        roster[i].name, roster[i].gladiatorID, predicted[i], hits[i]);
+                mismatches++;
+            }
+        }
+        fprintf(stderr, "prediction check : %d of %d gladiators differ\n", mismatches, rosterSize);
+    }
+    if (predict) {
+        memcpy(hits, predicted, rosterSize * sizeof(int));
+        free(predicted);
+        predictedHits = NULL;
+    }
+
+    int winner = deterministic ? deterministic_winner() : lastFinished;
+    if (winner >= 0) {
+        printf("The gods have spoken, the winner of the tournament is %s!\n", roster[winner].name);
+    }
+
+    if (showStats) {
+        const char* names[] = {"process", "thread", "pool"};
+        if (predict && !fight) names[model] = "none (--predict)";
+        struct rusage self, children;
+        getrusage(RUSAGE_SELF, &self);
+        getrusage(RUSAGE_CHILDREN, &children);
+        double battle = (fought.tv_sec - started.tv_sec) + (fought.tv_nsec - started.tv_nsec) / 1e9;
+        double render = (ended.tv_sec - fought.tv_sec) + (ended.tv_nsec - fought.tv_nsec) / 1e9;
+        fprintf(stderr, "spawn model      : %s\n", names[model]);
+        fprintf(stderr, "gladiators       : %d\n", rosterSize);
+        fprintf(stderr, "wall clock       : %.3f s (battle %.3f s, rendering logs %.3f s)\n",
+                battle + render, battle, render);
+        fprintf(stderr, "peak RSS         : %ld KB (tournament), %ld KB (largest child process)\n",
+                self.ru_maxrss, children.ru_maxrss);
+    }
 
+    free(hits);
+    free(roster);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,98 @@
+import argparse
+import csv
+import itertools
+import json
+import os
+import shutil
+import subprocess
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+POLICIES = ['FCFS', 'SJF', 'Priority', 'RR', 'SRTF', 'PPriority', 'MLFQ']
+# the policies whose result depends on the quantum
+QUANTUM_POLICIES = {'RR', 'MLFQ'}
+
+
+def build(work_dir):
+    program = os.path.join(work_dir, 'ex3')
+    subprocess.run(['gcc', '-O2', '-o', program, os.path.join(HERE, '..', 'ex3.c')], check=True)
+    return program
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * p / 100))]
+
+
+def run_policy(program, trace, policy, quantum, cores, work_dir):
+    prefix = os.path.join(work_dir, 'metrics')
+    command = [program, 'CPU-Scheduler', trace, str(quantum), '--virtual', '--sequential',
+               '--policies', policy, '--metrics', prefix, '-c', str(cores)]
+    started = time.perf_counter()
+    subprocess.run(command, stdout=subprocess.DEVNULL, check=True)
+    elapsed = time.perf_counter() - started
+
+    with open(f'{prefix}.{policy}.json') as f:
+        summary = json.load(f)
+    with open(f'{prefix}.{policy}.csv') as f:
+        responses = sorted(int(row['response']) for row in csv.DictReader(f))
+    return {
+        'wait': summary['average_waiting'],
+        'turnaround': summary['average_turnaround'],
+        'p99': percentile(responses, 99),
+        'switches': summary['context_switches'],
+        'runtime': elapsed,
+    }
+
+
+def generate(args, work_dir, arrivals, bursts):
+    trace = os.path.join(work_dir, f'trace_{arrivals}_{bursts}.csv')
+    subprocess.run(['python3', os.path.join(HERE, 'gen_trace.py'), str(args.count), trace,
+                    '--arrivals', arrivals, '--bursts', bursts, '--rate', str(args.rate),
+                    '--mean', str(args.mean), '--priorities', args.priorities, '--seed', str(args.seed),
+                    '--cores', str(max(args.cores) if max(args.cores) > 1 else 0)], check=True)
+    return trace
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Sweep the scheduling policies over synthetic traces')
+    parser.add_argument('--program', help='ex3 binary (default: build ../ex3.c with -O2)')
+    parser.add_argument('--count', type=int, default=10000, help='processes per trace')
+    parser.add_argument('--arrivals', default='poisson,bursty')
+    parser.add_argument('--bursts', default='exponential,pareto,lognormal')
+    parser.add_argument('--rate', type=float, default=0.2)
+    parser.add_argument('--mean', type=float, default=4.0)
+    parser.add_argument('--priorities', default='uniform')
+    parser.add_argument('--policies', default=','.join(POLICIES))
+    parser.add_argument('--quanta', default='1,2,4,8')
+    parser.add_argument('--cores', default='1')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--keep', action='store_true', help="don't delete the generated files")
+    args = parser.parse_args()
+    args.cores = [int(c) for c in args.cores.split(',')]
+
+    work_dir = tempfile.mkdtemp(prefix='scheduler_bench_')
+    try:
+        program = args.program or build(work_dir)
+        print(f"{'trace':<22} {'policy':<10} {'q':>3} {'cores':>5} {'avg wait':>10} {'avg turn':>10} "
+              f"{'p99 resp':>9} {'switches':>9} {'runtime':>9}")
+        for arrivals, bursts in itertools.product(args.arrivals.split(','), args.bursts.split(',')):
+            trace = generate(args, work_dir, arrivals, bursts)
+            for policy, cores in itertools.product(args.policies.split(','), args.cores):
+                quanta = args.quanta.split(',') if policy in QUANTUM_POLICIES else [args.quanta.split(',')[0]]
+                for quantum in quanta:
+                    r = run_policy(program, trace, policy, int(quantum), cores, work_dir)
+                    q = quantum if policy in QUANTUM_POLICIES else '-'
+                    print(f"{arrivals + '/' + bursts:<22} {policy:<10} {q:>3} {cores:>5} {r['wait']:>10.2f} "
+                          f"{r['turnaround']:>10.2f} {r['p99']:>9} {r['switches']:>9} {r['runtime']:>8.3f}s")
+    finally:
+        if args.keep:
+            print(f"files kept in {work_dir}")
+        else:
+            shutil.rmtree(work_dir)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,81 @@
+import argparse
+import math
+import random
+
+# writes a synthetic processes CSV for the CPU scheduler:
+#   python3 gen_trace.py 100000 trace.csv --arrivals bursty --bursts pareto --priorities zipf
+
+DESCRIPTIONS = ['Handles user login', 'Indexes system files', 'Compiles shaders', 'Streams audio',
+                'Checks for updates', 'Backs up the database', 'Renders thumbnails', 'Syncs mail']
+
+
+def arrival_times(args, rng):
+    """Poisson arrivals at --rate per time unit, or bursty ones: a Poisson process switching
+    between --rate * --burst-factor (on) and --rate / --burst-factor (off) every ~--burst-length units."""
+    t = 0.0
+    on = True
+    switch_at = rng.expovariate(1 / args.burst_length)
+    for _ in range(args.count):
+        rate = args.rate
+        if args.arrivals == 'bursty':
+            rate = args.rate * args.burst_factor if on else args.rate / args.burst_factor
+        t += rng.expovariate(rate)
+        while args.arrivals == 'bursty' and t > switch_at:
+            on = not on
+            switch_at += rng.expovariate(1 / args.burst_length)
+        yield int(t)
+
+
+def burst_time(args, rng):
+    """--mean burst length, exponential or heavy tailed (Pareto with --alpha, lognormal with --sigma)."""
+    if args.bursts == 'pareto':
+        scale = args.mean * (args.alpha - 1) / args.alpha
+        value = scale / (1 - rng.random()) ** (1 / args.alpha)
+    elif args.bursts == 'lognormal':
+        mu = math.log(args.mean) - args.sigma ** 2 / 2
+        value = rng.lognormvariate(mu, args.sigma)
+    else:
+        value = rng.expovariate(1 / args.mean)
+    return max(1, min(int(round(value)), args.max_burst))
+
+
+def priority(args, rng):
+    """1 (highest) to --levels, uniform, zipf (mostly high numbers = low priority) or bimodal."""
+    if args.priorities == 'zipf':
+        weights = [1 / k for k in range(1, args.levels + 1)]
+        return args.levels + 1 - rng.choices(range(1, args.levels + 1), weights)[0]
+    if args.priorities == 'bimodal':
+        return 1 if rng.random() < 0.2 else args.levels
+    return rng.randint(1, args.levels)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a synthetic process trace for the CPU scheduler')
+    parser.add_argument('count', type=int)
+    parser.add_argument('out')
+    parser.add_argument('--arrivals', choices=['poisson', 'bursty'], default='poisson')
+    parser.add_argument('--rate', type=float, default=0.2, help='arrivals per time unit')
+    parser.add_argument('--burst-factor', type=float, default=5.0)
+    parser.add_argument('--burst-length', type=float, default=50.0)
+    parser.add_argument('--bursts', choices=['exponential', 'pareto', 'lognormal'], default='exponential')
+    parser.add_argument('--mean', type=float, default=4.0, help='mean burst time')
+    parser.add_argument('--alpha', type=float, default=1.5, help='pareto shape, > 1')
+    parser.add_argument('--sigma', type=float, default=1.0, help='lognormal sigma')
+    parser.add_argument('--max-burst', type=int, default=10000)
+    parser.add_argument('--priorities', choices=['uniform', 'zipf', 'bimodal'], default='uniform')
+    parser.add_argument('--levels', type=int, default=5)
+    parser.add_argument('--cores', type=int, default=0, help='pin a tenth of the processes to one of N cores')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    with open(args.out, 'w') as f:
+        for i, arrival in enumerate(arrival_times(args, rng), 1):
+            line = f'P{i},{rng.choice(DESCRIPTIONS)},{arrival},{burst_time(args, rng)},{priority(args, rng)}'
+            if args.cores and rng.random() < 0.1:
+                line += f',{rng.randrange(args.cores)}'
+            f.write(line + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -3,66 +3,437 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <signal.h>
+#include <errno.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include "../common/os_instrument.h"
 
-#define MAX_PROCESSES 1000
-#define MAX_LINE 256
 #define MAX_NAME 50
 #define MAX_DESCRIPTION 100
+#define MAX_POLICIES 16
+#define MAX_MLFQ_LEVELS 8
+#define ARENA_BLOCK (1 << 20)
+#define LOADER_WINDOW (64 << 20)
+#define MAX_REPORTED_LINES 10
 
-// Proccess struct, contain all the fields for the algorithems
+// the names and descriptions of the table, each distinct string stored once. strings are
+// never moved once stored (blocks are only added), and slots is an open addressing hash set
 typedef struct {
-    pid_t pid;
-    char name[MAX_NAME];
-    char description[MAX_DESCRIPTION];
-    int arrivalTime;
-    int burstTime;
-    int priority;
-    int remainingTime;
-} Process;
-
-
-// Parse and init the data from the file into the structs
-int loadProcessesFromCSV(const char *filePath, Process procList[]) {
-    FILE *fp = fopen(filePath, "r");
-    if (!fp) {
-        perror("Unable to open CSV");
+    char **blocks;
+    int blockCount;
+    int blockCapacity;
+    size_t used;          // bytes used in the last block
+    char **slots;
+    size_t slotCount;     // a power of two
+    size_t filled;
+} StringArena;
+
+// the processes of the CSV, one array per field (struct of arrays) so the
+// algorithms only touch the fields they schedule by. grows as the file is read
+typedef struct {
+    int count;
+    int capacity;
+    pid_t *pid;
+    char **name;
+    char **description;
+    int *arrivalTime;
+    int *burstTime;
+    int *priority;
+    int *affinity;    // optional 6th CSV column: the core the process has to run on, -1 for any
+    StringArena strings;
+} ProcessTable;
+
+// the scheduling algorithms, in the order of their reports by default
+typedef enum {
+    POLICY_FCFS,
+    POLICY_SJF,
+    POLICY_PRIORITY,
+    POLICY_RR,
+    POLICY_SRTF,
+    POLICY_PREEMPTIVE_PRIORITY,
+    POLICY_MLFQ,
+    POLICY_COUNT
+} Policy;
+
+static const char *policyNames[POLICY_COUNT] = {"FCFS", "SJF", "Priority", "RR", "SRTF", "PPriority", "MLFQ"};
+
+// how the scheduler lets time pass, and what it runs
+typedef struct {
+    int virtualClock; // 0: every time unit is a real second (alarm in a child), 1: jump straight to the end
+    Policy policies[MAX_POLICIES];
+    int policyCount;  // 0: the classic four, FCFS SJF Priority RR
+    int aging;        // preemptive priority: a waiting process gains one priority level every aging units (0: never)
+    int mlfqQuanta[MAX_MLFQ_LEVELS];
+    int mlfqLevels;   // 0: three levels of quantum, 2*quantum, 4*quantum
+    int mlfqBoost;    // every mlfqBoost units all MLFQ processes go back to the top level (0: never)
+    int cores;        // 1: the single CPU engines above, more: runMultiCore on the virtual clock
+    int sequential;   // run the reports one after the other instead of each in its own process
+    int workload;     // real workload: one long-lived CPU-bound child per process, SIGSTOP/SIGCONT
+    int unitMs;       // length of a time unit for the worker pool and the workload mode
+    int workers;      // real mode: prefork pool size, 0 forks a child for every segment
+    int poolStats;    // print the dispatch latency of every pool worker to stderr
+    const char *metricsPrefix; // write <prefix>.<policy>.csv/.json/.gantt for every report (NULL: don't)
+    int metricsWindow;         // time units per sample of the utilization / throughput series
+} SchedulerConfig;
+
+static SchedulerConfig schedulerConfig = {.cores = 1, .unitMs = 1000, .metricsWindow = 10, .workers = 1};
+
+// "FCFS,SRTF,MLFQ" -> schedulerConfig.policies, -1 on an unknown name
+int parsePolicies(char *list) {
+    schedulerConfig.policyCount = 0;
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        int found = -1;
+        for (int p = 0; p < POLICY_COUNT; ++p)
+            if (strcasecmp(name, policyNames[p]) == 0) found = p;
+        if (found < 0 || schedulerConfig.policyCount == MAX_POLICIES) {
+            fprintf(stderr, "Unknown scheduling policy: %s\n", name);
+            return -1;
+        }
+        schedulerConfig.policies[schedulerConfig.policyCount++] = found;
+    }
+    return 0;
+}
+
+// "2,4,8" -> the quantum of each MLFQ level, top level first
+int parseMlfqQuanta(char *list) {
+    schedulerConfig.mlfqLevels = 0;
+    for (char *q = strtok(list, ","); q; q = strtok(NULL, ",")) {
+        if (atoi(q) <= 0 || schedulerConfig.mlfqLevels == MAX_MLFQ_LEVELS) {
+            fprintf(stderr, "Bad MLFQ quanta\n");
+            return -1;
+        }
+        schedulerConfig.mlfqQuanta[schedulerConfig.mlfqLevels++] = atoi(q);
+    }
+    return 0;
+}
+
+// parse the options after <Processes.csv> <Time-Quantum>, and check the quantum when a policy uses it.
+// returns -1 on a bad quantum or an unknown option
+int configureCPUScheduler(int quantum, int argc, char *argv[]) {
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--virtual") == 0) {
+            schedulerConfig.virtualClock = 1;
+        } else if (strcmp(argv[i], "--real") == 0) {
+            schedulerConfig.virtualClock = 0;
+        } else if (strcmp(argv[i], "--policies") == 0 && i + 1 < argc) {
+            if (parsePolicies(argv[++i]) < 0) return -1;
+        } else if (strcmp(argv[i], "--aging") == 0 && i + 1 < argc) {
+            schedulerConfig.aging = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mlfq") == 0 && i + 1 < argc) {
+            if (parseMlfqQuanta(argv[++i]) < 0) return -1;
+        } else if (strcmp(argv[i], "--mlfq-boost") == 0 && i + 1 < argc) {
+            schedulerConfig.mlfqBoost = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sequential") == 0) {
+            schedulerConfig.sequential = 1;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            schedulerConfig.metricsPrefix = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-window") == 0 && i + 1 < argc) {
+            schedulerConfig.metricsWindow = atoi(argv[++i]);
+            if (schedulerConfig.metricsWindow < 1) {
+                fprintf(stderr, "The metrics window has to be positive\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            schedulerConfig.workers = atoi(argv[++i]);
+            if (schedulerConfig.workers < 0) {
+                fprintf(stderr, "The number of workers can't be negative\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--pool-stats") == 0) {
+            schedulerConfig.poolStats = 1;
+        } else if (strcmp(argv[i], "--workload") == 0) {
+            schedulerConfig.workload = 1;
+        } else if (strcmp(argv[i], "--unit-ms") == 0 && i + 1 < argc) {
+            schedulerConfig.unitMs = atoi(argv[++i]);
+            if (schedulerConfig.unitMs < 1) {
+                fprintf(stderr, "The time unit has to be at least 1 ms\n");
+                return -1;
+            }
+        } else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--cores") == 0) && i + 1 < argc) {
+            schedulerConfig.cores = atoi(argv[++i]);
+            if (schedulerConfig.cores < 1) {
+                fprintf(stderr, "The number of cores has to be positive\n");
+                return -1;
+            }
+        } else {
+            fprintf(stderr, "Unknown CPU-Scheduler option: %s\n", argv[i]);
+            return -1;
+        }
+    }
+    // RR slices by the quantum, and so does MLFQ without --mlfq; the classic four include RR
+    int usesQuantum = schedulerConfig.policyCount == 0;
+    for (int p = 0; p < schedulerConfig.policyCount; ++p) {
+        Policy policy = schedulerConfig.policies[p];
+        if (policy == POLICY_RR || (policy == POLICY_MLFQ && schedulerConfig.mlfqLevels == 0)) usesQuantum = 1;
+    }
+    if (usesQuantum && quantum <= 0) {
+        fprintf(stderr, "The time quantum has to be positive\n");
+        return -1;
+    }
+    if (schedulerConfig.workload) {
+        if (schedulerConfig.cores > 1) {
+            fprintf(stderr, "--workload runs on a single core\n");
+            return -1;
+        }
+        // real time, and one report at a time so the reports don't compete for the CPU
+        schedulerConfig.virtualClock = 0;
+        schedulerConfig.sequential = 1;
+    }
+    return 0;
+}
+
+void growProcessTable(ProcessTable *t) {
+    int capacity = t->capacity ? t->capacity * 2 : 1024;
+    t->pid = realloc(t->pid, capacity * sizeof(*t->pid));
+    t->name = realloc(t->name, capacity * sizeof(*t->name));
+    t->description = realloc(t->description, capacity * sizeof(*t->description));
+    t->arrivalTime = realloc(t->arrivalTime, capacity * sizeof(*t->arrivalTime));
+    t->burstTime = realloc(t->burstTime, capacity * sizeof(*t->burstTime));
+    t->priority = realloc(t->priority, capacity * sizeof(*t->priority));
+    t->affinity = realloc(t->affinity, capacity * sizeof(*t->affinity));
+    if (!t->pid || !t->name || !t->description || !t->arrivalTime || !t->burstTime || !t->priority ||
+        !t->affinity) {
+        perror("Unable to grow the process table");
         exit(EXIT_FAILURE);
     }
+    t->capacity = capacity;
+}
+
+// FNV-1a
+size_t hashString(const char *s, size_t len) {
+    size_t h = 1469598103934665603ULL;
+    for (size_t k = 0; k < len; ++k) h = (h ^ (unsigned char)s[k]) * 1099511628211ULL;
+    return h;
+}
+
+// copy s[0, len) into the arena, unless the same string is already there
+const char *internString(StringArena *a, const char *s, size_t len) {
+    if (a->filled * 2 >= a->slotCount) {
+        size_t slotCount = a->slotCount ? a->slotCount * 2 : 1024;
+        char **slots = calloc(slotCount, sizeof(char *));
+        if (!slots) {
+            perror("Unable to grow the string arena");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t k = 0; k < a->slotCount; ++k) {
+            if (!a->slots[k]) continue;
+            size_t at = hashString(a->slots[k], strlen(a->slots[k])) & (slotCount - 1);
+            while (slots[at]) at = (at + 1) & (slotCount - 1);
+            slots[at] = a->slots[k];
+        }
+        free(a->slots);
+        a->slots = slots;
+        a->slotCount = slotCount;
+    }
+
+    size_t at = hashString(s, len) & (a->slotCount - 1);
+    for (; a->slots[at]; at = (at + 1) & (a->slotCount - 1))
+        if (memcmp(a->slots[at], s, len) == 0 && a->slots[at][len] == '\0') return a->slots[at];
+
+    if (a->blockCount == 0 || a->used + len + 1 > ARENA_BLOCK) {
+        if (a->blockCount == a->blockCapacity) {
+            a->blockCapacity = a->blockCapacity ? a->blockCapacity * 2 : 16;
+            a->blocks = realloc(a->blocks, a->blockCapacity * sizeof(char *));
+        }
+        a->blocks[a->blockCount++] = malloc(ARENA_BLOCK);
+        if (!a->blocks || !a->blocks[a->blockCount - 1]) {
+            perror("Unable to grow the string arena");
+            exit(EXIT_FAILURE);
+        }
+        a->used = 0;
+    }
+    char *copy = a->blocks[a->blockCount - 1] + a->used;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    a->used += len + 1;
+    a->slots[at] = copy;
+    a->filled++;
+    return copy;
+}
 
-    char line[MAX_LINE];
-    int count = 0;
+void freeProcessTable(ProcessTable *t) {
+    for (int b = 0; b < t->strings.blockCount; ++b) free(t->strings.blocks[b]);
+    free(t->strings.blocks);
+    free(t->strings.slots);
+    free(t->pid);
+    free(t->name);
+    free(t->description);
+    free(t->arrivalTime);
+    free(t->burstTime);
+    free(t->priority);
+    free(t->affinity);
+}
 
-    while (fgets(line, sizeof(line), fp) && count < MAX_PROCESSES) {
-        char *token = strtok(line, ",");
-        if (!token) continue;
-        strncpy(procList[count].name, token, MAX_NAME);
+// [s, e) as an int: blanks around it, an optional sign, digits and nothing else
+int parseField(const char *s, const char *e, int *out) {
+    while (s < e && (*s == ' ' || *s == '\t')) s++;
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) e--;
+    int negative = 0;
+    if (s < e && (*s == '-' || *s == '+')) negative = *s++ == '-';
+    if (s == e) return -1;
+    long long value = 0;
+    for (; s < e; ++s) {
+        if (*s < '0' || *s > '9') return -1;
+        value = value * 10 + (*s - '0');
+        if (value > __INT_MAX__) return -1;
+    }
+    *out = negative ? (int)-value : (int)value;
+    return 0;
+}
 
-        token = strtok(NULL, ",");
-        if (!token) continue;
-        strncpy(procList[count].description, token, MAX_DESCRIPTION);
+// parse the line [line, end) into the table. returns NULL, or why the line was rejected
+const char *parseProcessLine(ProcessTable *t, const char *line, const char *end) {
+    const char *field[7];
+    const char *fieldEnd[7];
+    int fields = 0;
+    for (const char *p = line;; ) {
+        if (fields == 7) return "too many fields";
+        const char *comma = memchr(p, ',', end - p);
+        field[fields] = p;
+        fieldEnd[fields++] = comma ? comma : end;
+        if (!comma) break;
+        p = comma + 1;
+    }
+    if (fields < 5) return "expected Name,Description,Arrival,Burst,Priority[,Core]";
+    if (fields > 6) return "too many fields";
+    if (fieldEnd[0] == field[0] || fieldEnd[1] == field[1]) return "empty name or description";
 
-        token = strtok(NULL, ",");
-        if (!token) continue;
-        procList[count].arrivalTime = atoi(token);
+    int arrival, burst, priority, core = -1;
+    if (parseField(field[2], fieldEnd[2], &arrival) < 0) return "bad arrival time";
+    if (parseField(field[3], fieldEnd[3], &burst) < 0 || burst < 0) return "bad burst time";
+    if (parseField(field[4], fieldEnd[4], &priority) < 0) return "bad priority";
+    if (fields == 6) {
+        const char *s = field[5], *e = fieldEnd[5];
+        while (s < e && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+        if (s < e && (parseField(s, e, &core) < 0 || core < 0)) return "bad core";
+    }
 
-        token = strtok(NULL, ",");
-        if (!token) continue;
-        procList[count].burstTime = atoi(token);
-        procList[count].remainingTime = procList[count].burstTime;
+    if (t->count == t->capacity) growProcessTable(t);
+    int i = t->count++;
+    size_t nameLength = fieldEnd[0] - field[0], descriptionLength = fieldEnd[1] - field[1];
+    t->pid[i] = 0;
+    t->name[i] = (char *)internString(&t->strings, field[0], nameLength < MAX_NAME ? nameLength : MAX_NAME);
+    t->description[i] = (char *)internString(&t->strings, field[1],
+                                             descriptionLength < MAX_DESCRIPTION ? descriptionLength : MAX_DESCRIPTION);
+    t->arrivalTime[i] = arrival;
+    t->burstTime[i] = burst;
+    t->priority[i] = priority;
+    t->affinity[i] = core;
+    return NULL;
+}
 
-        token = strtok(NULL, ",");
-        if (!token) continue;
-        procList[count].priority = atoi(token);
+// where loadProcessesFromCSV is in the trace, carried from one window to the next
+typedef struct {
+    long long lineNumber;
+    long long rejected;
+    int skipping;                // inside a line longer than a window, drop it up to its newline
+} CsvProgress;
 
-        count++;
+// parse the lines of one window [first, end). returns where the line that goes on in the next
+// window starts, end when there is none. the last window's last line needs no newline
+const char *loadCSVWindow(ProcessTable *t, const char *filePath, const char *first, const char *end,
+                          int lastWindow, CsvProgress *progress) {
+    const char *p = first;
+    if (progress->skipping) {
+        const char *newline = memchr(p, '\n', end - p);
+        p = newline ? newline + 1 : end;
+        progress->skipping = !newline;
+    }
+    while (p < end) {
+        const char *newline = memchr(p, '\n', end - p);
+        if (!newline && !lastWindow) {
+            if (p != first) return p; // the next window starts with it
+            progress->lineNumber++;
+            if (++progress->rejected <= MAX_REPORTED_LINES)
+                fprintf(stderr, "%s:%lld: skipped, line too long\n", filePath, progress->lineNumber);
+            progress->skipping = 1;
+            return end;
+        }
+        const char *lineEnd = newline ? newline : end;
+        progress->lineNumber++;
+        if (lineEnd > p && lineEnd[-1] == '\r') lineEnd--;
+        if (lineEnd > p && *p != '#') {
+            const char *error = parseProcessLine(t, p, lineEnd);
+            if (error && ++progress->rejected <= MAX_REPORTED_LINES)
+                fprintf(stderr, "%s:%lld: skipped, %s\n", filePath, progress->lineNumber, error);
+        }
+        p = newline ? newline + 1 : end;
     }
+    return end;
+}
 
-    fclose(fp);
-    return count;
+// a trace that can't be mapped (a pipe, /dev/stdin): the same windows, read into one buffer.
+// the line a window ends in moves to the front of the buffer and the next read fills the rest
+void streamCSV(int fd, const char *filePath, ProcessTable *t, CsvProgress *progress) {
+    char *window = malloc(LOADER_WINDOW);
+    if (!window) {
+        perror("Unable to read CSV");
+        exit(EXIT_FAILURE);
+    }
+    size_t used = 0;
+    int lastWindow = 0;
+    while (!lastWindow) {
+        while (used < LOADER_WINDOW) {
+            ssize_t n = read(fd, window + used, LOADER_WINDOW - used);
+            if (n < 0) {
+                perror("Unable to read CSV");
+                exit(EXIT_FAILURE);
+            }
+            if (n == 0) {
+                lastWindow = 1;
+                break;
+            }
+            used += n;
+        }
+        const char *rest = loadCSVWindow(t, filePath, window, window + used, lastWindow, progress);
+        used = window + used - rest;
+        memmove(window, rest, used);
+    }
+    free(window);
+}
+
+// Parse and init the data from the file into the table. the file is mapped (a pipe is read) one
+// window at a time, so memory stays bounded by the window and the table, whatever the size of the
+// trace. blank lines and # comments are skipped, malformed lines are rejected whole and reported
+int loadProcessesFromCSV(const char *filePath, ProcessTable *t) {
+    int fd = open(filePath, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("Unable to open CSV");
+        exit(EXIT_FAILURE);
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    off_t offset = 0;            // start of the first line not parsed yet
+    CsvProgress progress = {0, 0, 0};
+    if (!S_ISREG(st.st_mode)) streamCSV(fd, filePath, t, &progress);
+    while (S_ISREG(st.st_mode) && offset < st.st_size) {
+        off_t mapStart = offset - offset % page;
+        size_t mapLength = st.st_size - mapStart < LOADER_WINDOW ? st.st_size - mapStart : LOADER_WINDOW;
+        const char *map = mmap(NULL, mapLength, PROT_READ, MAP_PRIVATE, fd, mapStart);
+        if (map == MAP_FAILED) {
+            perror("Unable to map CSV");
+            exit(EXIT_FAILURE);
+        }
+        int lastWindow = mapStart + (off_t)mapLength == st.st_size;
+        const char *rest = loadCSVWindow(t, filePath, map + (offset - mapStart), map + mapLength, lastWindow,
+                                         &progress);
+        offset = mapStart + (rest - map);
+        munmap((void *)map, mapLength);
+    }
+    close(fd);
+
+    if (progress.rejected > MAX_REPORTED_LINES)
+        fprintf(stderr, "%s: %lld malformed lines skipped in total\n", filePath, progress.rejected);
+    return t->count;
 }
 
 // Printer functions
@@ -74,13 +445,13 @@ void printReportHeader(const char *mode) {
 }
 
 // Printer functions
-void printReportFooter(const char *label, float value, int isInt) {
+void printReportFooter(const char *label, double value, int isInt) {
     printf("\n");
     printf("──────────────────────────────────────────────\n");
     printf(">> Engine Status  : Completed\n");
     printf(">> Summary        :\n");
     if (isInt)
-        printf("   └─ %s : %d time units\n", label, (int)value);
+        printf("   └─ %s : %lld time units\n", label, (long long)value);
     else
         printf("   └─ %s : %.2f time units\n", label, value);
     printf(">> End of Report\n");
@@ -88,19 +459,85 @@ void printReportFooter(const char *label, float value, int isInt) {
 }
 
 // handle IDLE time
-void simulateIdleTime(int start, int end) {
-    printf("%d → %d: Idle.\n", start, end);
-}
-
-// simple implement of bubblesort
-void sortByArrival(Process p[], int n) {
-    for (int i = 0; i < n-1; ++i)
-        for (int j = 0; j < n-i-1; ++j)
-            if (p[j].arrivalTime > p[j+1].arrivalTime) {
-                Process tmp = p[j];
-                p[j] = p[j+1];
-                p[j+1] = tmp;
-            }
+void simulateIdleTime(long long start, long long end) {
+    printf("%lld → %lld: Idle.\n", start, end);
+}
+
+// stable merge sort of the process indices by arrival time, so equal arrivals keep
+// their CSV order. order[pos] is the index of the pos-th process to arrive
+int *sortByArrival(const ProcessTable *t) {
+    int n = t->count;
+    int *order = malloc((n ? n : 1) * sizeof(int));
+    int *tmp = malloc((n ? n : 1) * sizeof(int));
+    for (int i = 0; i < n; ++i) order[i] = i;
+
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int a = lo, b = mid, k = lo;
+            while (a < mid && b < hi)
+                tmp[k++] = (t->arrivalTime[order[b]] < t->arrivalTime[order[a]]) ? order[b++] : order[a++];
+            while (a < mid) tmp[k++] = order[a++];
+            while (b < hi) tmp[k++] = order[b++];
+        }
+        int *swap = order;
+        order = tmp;
+        tmp = swap;
+    }
+    free(tmp);
+    return order;
+}
+
+// min-heap of arrival positions, keyed by key[pos] and then by the position
+// itself (earlier arrival, then CSV order) like the tie rule of the algorithms
+typedef struct {
+    int *items;
+    int size;
+    const long long *key;
+    int capacity;     // heapPush grows items past it
+} ReadyHeap;
+
+int heapBefore(const ReadyHeap *h, int a, int b) {
+    return h->key[a] < h->key[b] || (h->key[a] == h->key[b] && a < b);
+}
+
+void heapPush(ReadyHeap *h, int pos) {
+    if (h->size == h->capacity) {
+        h->capacity = h->capacity ? h->capacity * 2 : 64;
+        h->items = realloc(h->items, h->capacity * sizeof(int));
+    }
+    int i = h->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heapBefore(h, pos, h->items[parent])) break;
+        h->items[i] = h->items[parent];
+        i = parent;
+    }
+    h->items[i] = pos;
+}
+
+int heapPop(ReadyHeap *h) {
+    int top = h->items[0];
+    int last = h->items[--h->size];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && heapBefore(h, h->items[child + 1], h->items[child])) child++;
+        if (!heapBefore(h, h->items[child], last)) break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->size > 0) h->items[i] = last;
+    return top;
+}
+
+// restore the heap order after the keys of its items changed
+void heapRebuild(ReadyHeap *h) {
+    int size = h->size;
+    h->size = 0;
+    for (int k = 0; k < size; ++k) heapPush(h, h->items[k]);
 }
 
 void alarmHandler(int sig) {
@@ -108,31 +545,308 @@ void alarmHandler(int sig) {
 }
 
 
-// execute process and invoke it
-void spawnChildProcess(Process *p, int *now, int *waitSum) {
-    pid_t pid = fork();
-    if (pid == 0) {
-        struct sigaction sa;
-        sa.sa_handler = alarmHandler;
-        sigemptyset(&sa.sa_mask);
-        sa.sa_flags = 0;
-        sigaction(SIGALRM, &sa, NULL);
-        alarm(p->burstTime);
-        pause();
-        exit(EXIT_SUCCESS);
+// --workload: every process is one child that spins on a CPU-bound kernel from its first
+// dispatch until it has been served its whole burst. the scheduler stops and resumes it with
+// SIGSTOP/SIGCONT and reaps it with its rusage at the end
+typedef struct {
+    int *served;                // time units each process has run so far
+    int *dispatches;
+    double *latencySum;         // ms from SIGCONT to the child running again
+    double *latencyMax;
+    struct rusage *usage;       // of the reaped child
+    struct timespec *resumedAt; // shared with the children, written by their SIGCONT handler
+    size_t sharedSize;
+    struct timespec started;
+} Workload;
+
+static Workload workload;
+static int workloadSlot;        // in a workload child: its index in resumedAt
+
+void workloadContinued(int sig) {
+    (void)sig;
+    clock_gettime(CLOCK_MONOTONIC, &workload.resumedAt[workloadSlot]);
+}
+
+// the "real CPU work" of a workload child
+void workloadKernel(int i) {
+    workloadSlot = i;
+    struct sigaction sa;
+    sa.sa_handler = workloadContinued;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGCONT, &sa, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &workload.resumedAt[i]);
+
+    volatile unsigned long long state = 88172645463325252ULL + i;
+    for (;;) {
+        unsigned long long x = state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        state = x;
+    }
+}
+
+double msBetween(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1e3 + (to->tv_nsec - from->tv_nsec) / 1e6;
+}
+
+void workloadBegin(ProcessTable *t) {
+    int n = t->count ? t->count : 1;
+    workload.served = calloc(n, sizeof(int));
+    workload.dispatches = calloc(n, sizeof(int));
+    workload.latencySum = calloc(n, sizeof(double));
+    workload.latencyMax = calloc(n, sizeof(double));
+    workload.usage = calloc(n, sizeof(struct rusage));
+    // a tmpfile mapping is the shared memory the children write their resume times into
+    workload.sharedSize = n * sizeof(struct timespec);
+    FILE *shared = tmpfile();
+    if (!shared || ftruncate(fileno(shared), workload.sharedSize) < 0 ||
+        (workload.resumedAt = mmap(NULL, workload.sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                   fileno(shared), 0)) == MAP_FAILED) {
+        perror("Unable to share the workload clock");
+        exit(EXIT_FAILURE);
+    }
+    fclose(shared);
+    for (int i = 0; i < t->count; ++i) t->pid[i] = 0;
+    clock_gettime(CLOCK_MONOTONIC, &workload.started);
+}
+
+// reap child i once it got its whole burst; the RUSAGE_CHILDREN difference is its own usage
+void workloadReap(ProcessTable *t, int i) {
+    struct rusage before, after;
+    getrusage(RUSAGE_CHILDREN, &before);
+    kill(t->pid[i], SIGKILL);
+    unsigned long long wait = os_instrument_begin();
+    waitpid(t->pid[i], NULL, 0);
+    os_instrument_end(OS_WAIT, wait);
+    getrusage(RUSAGE_CHILDREN, &after);
+    struct rusage *u = &workload.usage[i];
+    u->ru_utime.tv_sec = after.ru_utime.tv_sec - before.ru_utime.tv_sec;
+    u->ru_utime.tv_usec = after.ru_utime.tv_usec - before.ru_utime.tv_usec;
+    u->ru_stime.tv_sec = after.ru_stime.tv_sec - before.ru_stime.tv_sec;
+    u->ru_stime.tv_usec = after.ru_stime.tv_usec - before.ru_stime.tv_usec;
+    u->ru_nvcsw = after.ru_nvcsw - before.ru_nvcsw;
+    u->ru_nivcsw = after.ru_nivcsw - before.ru_nivcsw;
+}
+
+// let process i's child run for duration time units
+void runWorkloadSegment(ProcessTable *t, int i, int duration) {
+    struct timespec sent;
+    clock_gettime(CLOCK_MONOTONIC, &sent);
+    if (t->pid[i] == 0) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) workloadKernel(i);
+        t->pid[i] = pid;
     } else {
-        p->pid = pid;
-        printf("%d → %d: %s Running %s.\n", *now, *now + p->burstTime, p->name, p->description);
-        *waitSum += (*now - p->arrivalTime);
-        sleep(p->burstTime);
-        kill(pid, SIGALRM);
-        waitpid(pid, NULL, 0);
-        *now += p->burstTime;
+        kill(t->pid[i], SIGCONT);
     }
+
+    long long ms = (long long)duration * schedulerConfig.unitMs;
+    struct timespec slice = {ms / 1000, (ms % 1000) * 1000000L};
+    while (nanosleep(&slice, &slice) < 0) {}
+
+    kill(t->pid[i], SIGSTOP);
+    unsigned long long wait = os_instrument_begin();
+    waitpid(t->pid[i], NULL, WUNTRACED);
+    os_instrument_end(OS_WAIT, wait);
+
+    double latency = msBetween(&sent, &workload.resumedAt[i]);
+    if (latency < 0) latency = 0;
+    workload.latencySum[i] += latency;
+    if (latency > workload.latencyMax[i]) workload.latencyMax[i] = latency;
+    workload.dispatches[i]++;
+    workload.served[i] += duration;
+    if (workload.served[i] >= t->burstTime[i]) workloadReap(t, i);
 }
 
-// manege the same goals but for RR algorithem
-void spawnChildProcessRR(Process *p, int *now, int *waitSum, int duration) {
+// what the kernel measured, printed after the report of the policy
+void workloadEnd(ProcessTable *t, const char *mode) {
+    struct timespec ended;
+    clock_gettime(CLOCK_MONOTONIC, &ended);
+    double cpuTotal = 0;
+
+    printf(">> Measured Workload : %s\n", mode);
+    for (int i = 0; i < t->count; ++i) {
+        // a process that never finished (burst 0 or no dispatch) still has to go
+        if (t->pid[i] > 0 && workload.served[i] < t->burstTime[i]) workloadReap(t, i);
+        struct rusage *u = &workload.usage[i];
+        double user = u->ru_utime.tv_sec + u->ru_utime.tv_usec / 1e6;
+        double sys = u->ru_stime.tv_sec + u->ru_stime.tv_usec / 1e6;
+        cpuTotal += user + sys;
+        printf("   %s : cpu %.3f s (user %.3f, sys %.3f) for %.3f s planned, %d dispatches, "
+               "%ld voluntary / %ld involuntary switches, resume latency %.3f ms avg / %.3f ms max\n",
+               t->name[i], user + sys, user, sys, t->burstTime[i] * schedulerConfig.unitMs / 1e3,
+               workload.dispatches[i], u->ru_nvcsw, u->ru_nivcsw,
+               workload.dispatches[i] ? workload.latencySum[i] / workload.dispatches[i] : 0.0,
+               workload.latencyMax[i]);
+    }
+    printf("   └─ Total CPU : %.3f s in %.3f s of wall time\n", cpuTotal, msBetween(&workload.started, &ended) / 1e3);
+    printf("══════════════════════════════════════════════\n\n");
+
+    munmap(workload.resumedAt, workload.sharedSize);
+    free(workload.served);
+    free(workload.dispatches);
+    free(workload.latencySum);
+    free(workload.latencyMax);
+    free(workload.usage);
+}
+
+// the real mode's prefork pool: workers forked once per report, each waiting on its command
+// pipe for a segment to "run" (an interval timer and sigsuspend), then answering on its reply
+// pipe. process i always goes to worker i % workers
+typedef struct {
+    int duration;
+    int unitMs;
+    struct timespec sent;
+} PoolCommand;
+
+typedef struct {
+    pid_t pid;
+    int command;        // write end of the worker's command pipe
+    int reply;          // read end of its reply pipe
+    long dispatches;
+    double latencySum;  // ms from the command being sent to the worker picking it up
+    double latencyMax;
+} PoolWorker;
+
+static PoolWorker *pool;
+static int poolSize;
+
+ssize_t readFull(int fd, void *buffer, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, (char *)buffer + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return n;
+        done += n;
+    }
+    return done;
+}
+
+void poolWorkerLoop(int command, int reply) {
+    struct sigaction sa;
+    sa.sa_handler = alarmHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGALRM, &sa, NULL);
+
+    // SIGALRM stays blocked outside sigsuspend, so it can't fire before we wait for it
+    sigset_t blocked, waiting;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGALRM);
+    sigprocmask(SIG_BLOCK, &blocked, &waiting);
+    sigdelset(&waiting, SIGALRM);
+
+    PoolCommand cmd;
+    while (readFull(command, &cmd, sizeof(cmd)) == sizeof(cmd)) {
+        struct timespec received;
+        clock_gettime(CLOCK_MONOTONIC, &received);
+        double latency = msBetween(&cmd.sent, &received);
+        if (cmd.duration > 0) {
+            long long ms = (long long)cmd.duration * cmd.unitMs;
+            struct itimerval timer = {{0, 0}, {ms / 1000, (ms % 1000) * 1000}};
+            setitimer(ITIMER_REAL, &timer, NULL);
+            sigsuspend(&waiting);
+        }
+        if (write(reply, &latency, sizeof(latency)) != sizeof(latency)) break;
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+void poolStart(void) {
+    poolSize = schedulerConfig.workers;
+    pool = calloc(poolSize, sizeof(PoolWorker));
+    fflush(stdout);
+    for (int w = 0; w < poolSize; ++w) {
+        int command[2], reply[2];
+        if (pipe(command) < 0 || pipe(reply) < 0) {
+            perror("Unable to create the worker pipes");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Unable to fork a worker");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            // only our own pipe ends, so the workers see EOF once the scheduler closes theirs
+            for (int other = 0; other < w; ++other) {
+                close(pool[other].command);
+                close(pool[other].reply);
+            }
+            close(command[1]);
+            close(reply[0]);
+            poolWorkerLoop(command[0], reply[1]);
+        }
+        close(command[0]);
+        close(reply[1]);
+        pool[w] = (PoolWorker){pid, command[1], reply[0], 0, 0, 0};
+    }
+}
+
+// close the pipes (the workers leave on EOF), reap them and report their latency
+void poolStop(const char *mode) {
+    if (!pool) return;
+    for (int w = 0; w < poolSize; ++w) {
+        close(pool[w].command);
+        close(pool[w].reply);
+        unsigned long long wait = os_instrument_begin();
+        waitpid(pool[w].pid, NULL, 0);
+        os_instrument_end(OS_WAIT, wait);
+        if (schedulerConfig.poolStats)
+            fprintf(stderr, "%s worker %d: %ld dispatches, latency %.3f ms avg / %.3f ms max\n", mode, w,
+                    pool[w].dispatches, pool[w].dispatches ? pool[w].latencySum / pool[w].dispatches : 0.0,
+                    pool[w].latencyMax);
+    }
+    free(pool);
+    pool = NULL;
+}
+
+void poolRunSegment(ProcessTable *t, int i, int duration) {
+    if (!pool) poolStart();
+    PoolWorker *worker = &pool[i % poolSize];
+    PoolCommand cmd = {.duration = duration, .unitMs = schedulerConfig.unitMs};
+    clock_gettime(CLOCK_MONOTONIC, &cmd.sent);
+    double latency;
+    unsigned long long io = os_instrument_begin();
+    ssize_t sent = write(worker->command, &cmd, sizeof(cmd));
+    os_instrument_end_bytes(OS_WRITE, io, sent);
+    // the reply comes once the segment is over, so this is mostly the segment itself
+    io = os_instrument_begin();
+    ssize_t replied = sent == sizeof(cmd) ? readFull(worker->reply, &latency, sizeof(latency)) : -1;
+    os_instrument_end_bytes(OS_READ, io, replied);
+    if (sent != sizeof(cmd) || replied != sizeof(latency)) {
+        perror("Worker pool");
+        exit(EXIT_FAILURE);
+    }
+    t->pid[i] = worker->pid;
+    worker->dispatches++;
+    worker->latencySum += latency;
+    if (latency > worker->latencyMax) worker->latencyMax = latency;
+}
+
+// run process i for duration time units: a pool worker (or with --workers 0 a new child)
+// that waits for its alarm in real mode, the process's own workload child with --workload,
+// nothing at all on the virtual clock
+void runSegment(ProcessTable *t, int i, int duration) {
+    if (schedulerConfig.virtualClock) return;
+    if (schedulerConfig.workload) {
+        runWorkloadSegment(t, i, duration);
+        return;
+    }
+    if (schedulerConfig.workers > 0) {
+        poolRunSegment(t, i, duration);
+        return;
+    }
+
+    // the child gets a copy of stdout's buffer, empty it first
+    fflush(stdout);
     pid_t pid = fork();
     if (pid == 0) {
         struct sigaction sa;
@@ -142,176 +856,869 @@ void spawnChildProcessRR(Process *p, int *now, int *waitSum, int duration) {
         sigaction(SIGALRM, &sa, NULL);
         alarm(duration);
         pause();
-        exit(EXIT_SUCCESS);
+        _exit(EXIT_SUCCESS);
     } else {
-        p->pid = pid;
-        char exec[256];
-        snprintf(exec, sizeof(exec), "%d → %d: %s Running %s.\n",
-                 *now, *now + duration, p->name, p->description);
-        write(STDOUT_FILENO, exec, strlen(exec));
-        *waitSum += (*now - p->arrivalTime);
+        t->pid[i] = pid;
         sleep(duration);
         kill(pid, SIGALRM);
+        unsigned long long wait = os_instrument_begin();
         waitpid(pid, NULL, 0);
-        *now += duration;
+        os_instrument_end(OS_WAIT, wait);
     }
 }
 
+// --metrics: every segment any policy runs goes through recordSegment, which keeps the per
+// process numbers, the busy time and completions of every window, and the Gantt trace
+typedef struct {
+    int active;
+    long long *firstStart;      // -1 until the first dispatch
+    long long *completion;
+    long long *served;
+    int *dispatches;
+    int *switches;              // dispatches that replaced another process on the core
+    int *lastOnCore;
+    int cores;
+    long long *windowBusy;
+    int *windowCompleted;
+    long long windows;
+    long long makespan;
+    FILE *gantt;
+} Metrics;
 
-// FCFS Algorithem
-void runFCFS(Process p[], int count) {
-    sortByArrival(p, count);
-    printReportHeader("FCFS");
+static Metrics metrics;
 
-    int time = 0, waitSum = 0;
-    for (int i = 0; i < count; ++i) {
-        if (p[i].arrivalTime > time) {
-            simulateIdleTime(time, p[i].arrivalTime);
-            time = p[i].arrivalTime;
-        }
-        spawnChildProcess(&p[i], &time, &waitSum);
+FILE *openMetricsFile(const char *policy, const char *extension) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.%s.%s", schedulerConfig.metricsPrefix, policy, extension);
+    FILE *f = fopen(path, "w");
+    if (!f) perror(path);
+    return f;
+}
+
+void metricsBegin(ProcessTable *t, const char *policy) {
+    int n = t->count ? t->count : 1;
+    metrics.firstStart = malloc(n * sizeof(long long));
+    metrics.completion = calloc(n, sizeof(long long));
+    metrics.served = calloc(n, sizeof(long long));
+    metrics.dispatches = calloc(n, sizeof(int));
+    metrics.switches = calloc(n, sizeof(int));
+    for (int i = 0; i < t->count; ++i) metrics.firstStart[i] = -1;
+    metrics.cores = schedulerConfig.cores;
+    metrics.lastOnCore = malloc(metrics.cores * sizeof(int));
+    for (int c = 0; c < metrics.cores; ++c) metrics.lastOnCore[c] = -1;
+    metrics.windowBusy = NULL;
+    metrics.windowCompleted = NULL;
+    metrics.windows = 0;
+    metrics.makespan = 0;
+    metrics.gantt = openMetricsFile(policy, "gantt");
+    if (metrics.gantt) fprintf(metrics.gantt, "# core start end name\n");
+    metrics.active = 1;
+}
+
+// make sure the series covers the window of time unit at
+void metricsGrowWindows(long long at) {
+    long long needed = at / schedulerConfig.metricsWindow + 1;
+    if (needed <= metrics.windows) return;
+    long long capacity = metrics.windows ? metrics.windows : 64;
+    while (capacity < needed) capacity *= 2;
+    metrics.windowBusy = realloc(metrics.windowBusy, capacity * sizeof(long long));
+    metrics.windowCompleted = realloc(metrics.windowCompleted, capacity * sizeof(int));
+    for (long long w = metrics.windows; w < capacity; ++w) {
+        metrics.windowBusy[w] = 0;
+        metrics.windowCompleted[w] = 0;
     }
+    metrics.windows = capacity;
+}
 
-    printReportFooter("Average Waiting Time", (float)waitSum / count, 0);
+void recordSegment(ProcessTable *t, int i, long long start, long long end, int core) {
+    if (!metrics.active) return;
+    if (metrics.firstStart[i] < 0) metrics.firstStart[i] = start;
+    metrics.dispatches[i]++;
+    if (metrics.lastOnCore[core] >= 0 && metrics.lastOnCore[core] != i) metrics.switches[i]++;
+    metrics.lastOnCore[core] = i;
+    metrics.served[i] += end - start;
+    if (end > metrics.makespan) metrics.makespan = end;
+
+    // spread the busy time over the windows it covers
+    long long window = schedulerConfig.metricsWindow;
+    metricsGrowWindows(end);
+    for (long long from = start; from < end;) {
+        long long to = (from / window + 1) * window;
+        if (to > end) to = end;
+        metrics.windowBusy[from / window] += to - from;
+        from = to;
+    }
+    if (metrics.served[i] >= t->burstTime[i]) {
+        metrics.completion[i] = end;
+        // a completion at a window boundary belongs to the window it closes
+        metrics.windowCompleted[end > 0 ? (end - 1) / window : 0]++;
+    }
+    if (metrics.gantt) fprintf(metrics.gantt, "%d %lld %lld %s\n", core, start, end, t->name[i]);
 }
 
-// SJF Algorithem
-void runSJF(Process p[], int count) {
-    printReportHeader("SJF");
+// a burst of 0 is done the moment it arrives: RR, SRTF, preemptive Priority and MLFQ skip it instead
+// of running a zero-length slice. the classic FCFS, SJF and Priority reports still print its t → t line
+int skipEmptyBurst(ProcessTable *t, int i) {
+    if (t->burstTime[i] > 0) return 0;
+    if (metrics.active) {
+        long long at = t->arrivalTime[i];
+        metrics.firstStart[i] = metrics.completion[i] = at;
+        metricsGrowWindows(at);
+        metrics.windowCompleted[at > 0 ? (at - 1) / schedulerConfig.metricsWindow : 0]++;
+    }
+    return 1;
+}
 
-    int time = 0, completed = 0, waitSum = 0;
-    int done[MAX_PROCESSES] = {0};
+// past the empty bursts that arrive next, so those policies don't idle waiting for one. returns the new next
+int skipEmptyArrivals(ProcessTable *t, const int *order, int next) {
+    while (next < t->count && skipEmptyBurst(t, order[next])) next++;
+    return next;
+}
 
-    while (completed < count) {
-        int minBurst = __INT_MAX__, index = -1;
-        int nextArrival = -1;
+// per process CSV and the JSON summary with the utilization / throughput series
+void metricsEnd(ProcessTable *t, const char *policy) {
+    if (!metrics.active) return;
+    metrics.active = 0;
+    if (metrics.gantt) fclose(metrics.gantt);
 
-        for (int i = 0; i < count; ++i) {
-            if (!done[i] && p[i].arrivalTime <= time) {
-                if (p[i].burstTime < minBurst || 
-                   (p[i].burstTime == minBurst && p[i].arrivalTime < p[index].arrivalTime)) {
-                    minBurst = p[i].burstTime;
-                    index = i;
-                }
-            } else if (!done[i] && (nextArrival == -1 || p[i].arrivalTime < nextArrival)) {
-                nextArrival = p[i].arrivalTime;
-            }
-        }
+    double responseSum = 0, waitingSum = 0, turnaroundSum = 0;
+    long long busy = 0, switches = 0;
+    FILE *csv = openMetricsFile(policy, "csv");
+    if (csv) fprintf(csv, "name,arrival,burst,priority,first_run,completion,response,waiting,turnaround,dispatches,context_switches\n");
+    for (int i = 0; i < t->count; ++i) {
+        long long response = metrics.firstStart[i] - t->arrivalTime[i];
+        long long turnaround = metrics.completion[i] - t->arrivalTime[i];
+        long long waiting = turnaround - t->burstTime[i];
+        responseSum += response;
+        waitingSum += waiting;
+        turnaroundSum += turnaround;
+        busy += metrics.served[i];
+        switches += metrics.switches[i];
+        if (csv) fprintf(csv, "%s,%d,%d,%d,%lld,%lld,%lld,%lld,%lld,%d,%d\n", t->name[i], t->arrivalTime[i],
+                         t->burstTime[i], t->priority[i], metrics.firstStart[i], metrics.completion[i],
+                         response, waiting, turnaround, metrics.dispatches[i], metrics.switches[i]);
+    }
+    if (csv) fclose(csv);
 
-        if (index == -1) {
-            simulateIdleTime(time, nextArrival);
-            time = nextArrival;
-            continue;
+    int n = t->count ? t->count : 1;
+    long long span = metrics.makespan ? metrics.makespan : 1;
+    long long window = schedulerConfig.metricsWindow;
+    FILE *json = openMetricsFile(policy, "json");
+    if (json) {
+        fprintf(json, "{\n  \"policy\": \"%s\",\n  \"cores\": %d,\n  \"processes\": %d,\n", policy, metrics.cores, t->count);
+        fprintf(json, "  \"makespan\": %lld,\n  \"busy\": %lld,\n  \"utilization\": %.4f,\n  \"throughput\": %.6f,\n",
+                metrics.makespan, busy, (double)busy / (span * metrics.cores), (double)t->count / span);
+        fprintf(json, "  \"average_response\": %.4f,\n  \"average_waiting\": %.4f,\n  \"average_turnaround\": %.4f,\n",
+                responseSum / n, waitingSum / n, turnaroundSum / n);
+        fprintf(json, "  \"context_switches\": %lld,\n  \"window\": %lld,\n  \"series\": [", switches, window);
+        long long used = metrics.makespan / window + (metrics.makespan % window != 0);
+        for (long long w = 0; w < used; ++w) {
+            long long length = (w + 1) * window <= metrics.makespan ? window : metrics.makespan - w * window;
+            fprintf(json, "%s\n    {\"start\": %lld, \"utilization\": %.4f, \"completed\": %d, \"throughput\": %.6f}",
+                    w ? "," : "", w * window, (double)metrics.windowBusy[w] / (length * metrics.cores),
+                    metrics.windowCompleted[w], (double)metrics.windowCompleted[w] / length);
         }
-
-        spawnChildProcess(&p[index], &time, &waitSum);
-        done[index] = 1;
-        completed++;
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
     }
 
-    printReportFooter("Average Waiting Time", (float)waitSum / count, 0);
+    free(metrics.firstStart);
+    free(metrics.completion);
+    free(metrics.served);
+    free(metrics.dispatches);
+    free(metrics.switches);
+    free(metrics.lastOnCore);
+    free(metrics.windowBusy);
+    free(metrics.windowCompleted);
 }
 
-// Priority Algorithem
-void runPriority(Process p[], int count) {
-    printReportHeader("Priority");
+// execute process and invoke it
+void spawnChildProcess(ProcessTable *t, int i, long long *now, long long *waitSum) {
+    printf("%lld → %lld: %s Running %s.\n", *now, *now + t->burstTime[i], t->name[i], t->description[i]);
+    recordSegment(t, i, *now, *now + t->burstTime[i], 0);
+    *waitSum += (*now - t->arrivalTime[i]);
+    runSegment(t, i, t->burstTime[i]);
+    *now += t->burstTime[i];
+}
 
-    int time = 0, completed = 0, waitSum = 0;
-    int done[MAX_PROCESSES] = {0};
+// print and run process i from *now until end, for the preemptive algorithms
+void runStretch(ProcessTable *t, int i, long long *now, long long end) {
+    printf("%lld → %lld: %s Running %s.\n", *now, end, t->name[i], t->description[i]);
+    recordSegment(t, i, *now, end, 0);
+    runSegment(t, i, (int)(end - *now));
+    *now = end;
+}
 
-    while (completed < count) {
-        int minPrio = __INT_MAX__, index = -1;
-        int nextArrival = -1;
+// manege the same goals but for RR algorithem
+void spawnChildProcessRR(ProcessTable *t, int i, long long *now, long long *waitSum, int duration) {
+    printf("%lld → %lld: %s Running %s.\n", *now, *now + duration, t->name[i], t->description[i]);
+    recordSegment(t, i, *now, *now + duration, 0);
+    *waitSum += (*now - t->arrivalTime[i]);
+    runSegment(t, i, duration);
+    *now += duration;
+}
 
-        for (int i = 0; i < count; ++i) {
-            if (!done[i] && p[i].arrivalTime <= time) {
-                if (p[i].priority < minPrio || 
-                   (p[i].priority == minPrio && p[i].arrivalTime < p[index].arrivalTime)) {
-                    minPrio = p[i].priority;
-                    index = i;
-                }
-            } else if (!done[i] && (nextArrival == -1 || p[i].arrivalTime < nextArrival)) {
-                nextArrival = p[i].arrivalTime;
-            }
+
+// FCFS Algorithem
+void runFCFS(ProcessTable *t, const int *order) {
+    printReportHeader("FCFS");
+
+    long long time = 0, waitSum = 0;
+    for (int pos = 0; pos < t->count; ++pos) {
+        int i = order[pos];
+        if (t->arrivalTime[i] > time) {
+            simulateIdleTime(time, t->arrivalTime[i]);
+            time = t->arrivalTime[i];
         }
+        spawnChildProcess(t, i, &time, &waitSum);
+    }
+
+    printReportFooter("Average Waiting Time", (double)waitSum / t->count, 0);
+}
 
-        if (index == -1) {
-            simulateIdleTime(time, nextArrival);
-            time = nextArrival;
+// SJF and Priority: the arrived processes wait in a heap keyed by key,
+// the next arrival is always order[next]
+void runByKey(ProcessTable *t, const int *order, const int *field) {
+    long long *key = malloc((t->count ? t->count : 1) * sizeof(long long));
+    for (int pos = 0; pos < t->count; ++pos)
+        key[pos] = field[order[pos]];
+    ReadyHeap ready = {malloc((t->count ? t->count : 1) * sizeof(int)), 0, key, t->count ? t->count : 1};
+    long long time = 0, waitSum = 0;
+    int next = 0;
+
+    while (next < t->count || ready.size > 0) {
+        while (next < t->count && t->arrivalTime[order[next]] <= time)
+            heapPush(&ready, next++);
+
+        if (ready.size == 0) {
+            simulateIdleTime(time, t->arrivalTime[order[next]]);
+            time = t->arrivalTime[order[next]];
             continue;
         }
 
-        spawnChildProcess(&p[index], &time, &waitSum);
-        done[index] = 1;
-        completed++;
+        spawnChildProcess(t, order[heapPop(&ready)], &time, &waitSum);
     }
 
-    printReportFooter("Average Waiting Time", (float)waitSum / count, 0);
+    free(ready.items);
+    free(key);
+    printReportFooter("Average Waiting Time", (double)waitSum / t->count, 0);
+}
+
+// SJF Algorithem
+void runSJF(ProcessTable *t, const int *order) {
+    printReportHeader("SJF");
+    runByKey(t, order, t->burstTime);
+}
+
+// Priority Algorithem
+void runPriority(ProcessTable *t, const int *order) {
+    printReportHeader("Priority");
+    runByKey(t, order, t->priority);
 }
 
 // RR Algorithem
-void runRR(Process p[], int count, int quantum) {
+void runRR(ProcessTable *t, const int *order, int quantum) {
     printReportHeader("Round Robin");
 
-    int time = 0, completed = 0, waitSum = 0;
-    int remaining[MAX_PROCESSES], inQueue[MAX_PROCESSES] = {0}, done[MAX_PROCESSES] = {0};
-    int queue[MAX_PROCESSES], front = 0, rear = -1, qSize = 0;
+    int count = t->count;
+    long long time = 0, waitSum = 0;
+    // a process is in the queue at most once, so count slots are enough
+    int *queue = malloc((count ? count : 1) * sizeof(int));
+    int *remaining = malloc((count ? count : 1) * sizeof(int));
+    int front = 0, rear = -1, qSize = 0, next = 0;
 
     for (int i = 0; i < count; ++i)
-        remaining[i] = p[i].burstTime;
-
-    while (completed < count) {
-        for (int i = 0; i < count; ++i) {
-            if (!done[i] && !inQueue[i] && p[i].arrivalTime <= time && remaining[i] > 0) {
-                rear = (rear + 1) % MAX_PROCESSES;
-                queue[rear] = i;
-                qSize++;
-                inQueue[i] = 1;
-            }
+        remaining[i] = t->burstTime[i];
+
+    while (next < count || qSize > 0) {
+        // the new arrivals queue up behind the process that just used its quantum
+        while (next < count && t->arrivalTime[order[next]] <= time) {
+            int i = order[next++];
+            if (skipEmptyBurst(t, i)) continue;
+            rear = (rear + 1) % count;
+            queue[rear] = i;
+            qSize++;
         }
 
         if (qSize == 0) {
-            int nextArrival = -1;
-            for (int i = 0; i < count; ++i)
-                if (!done[i] && p[i].arrivalTime > time && 
-                    (nextArrival == -1 || p[i].arrivalTime < nextArrival))
-                    nextArrival = p[i].arrivalTime;
-
-            simulateIdleTime(time, nextArrival);
-            time = nextArrival;
+            next = skipEmptyArrivals(t, order, next);
+            if (next == count) break;
+            simulateIdleTime(time, t->arrivalTime[order[next]]);
+            time = t->arrivalTime[order[next]];
             continue;
         }
 
         int idx = queue[front];
-        front = (front + 1) % MAX_PROCESSES;
+        front = (front + 1) % count;
         qSize--;
-        inQueue[idx] = 0;
 
         int execTime = (remaining[idx] < quantum) ? remaining[idx] : quantum;
-        spawnChildProcessRR(&p[idx], &time, &waitSum, execTime);
+        spawnChildProcessRR(t, idx, &time, &waitSum, execTime);
         remaining[idx] -= execTime;
 
-        if (remaining[idx] == 0) {
-            done[idx] = 1;
-            completed++;
-        } else {
-            rear = (rear + 1) % MAX_PROCESSES;
+        if (remaining[idx] > 0) {
+            rear = (rear + 1) % count;
             queue[rear] = idx;
             qSize++;
-            inQueue[idx] = 1;
         }
     }
 
+    free(queue);
+    free(remaining);
     printReportFooter("Total Turnaround Time", time, 1);
 }
 
 
+// key of a ready process for the preemptive algorithms: its remaining time for SRTF, its
+// priority for preemptive Priority. with aging, a process that became ready at readySince
+// is ahead of the same priority one aging units younger, so priority * aging + readySince
+// orders them without touching the heap as time passes
+long long preemptiveKey(ProcessTable *t, int i, int srtf, int remaining, long long readySince) {
+    if (srtf) return remaining;
+    if (schedulerConfig.aging > 0) return (long long)t->priority[i] * schedulerConfig.aging + readySince;
+    return t->priority[i];
+}
+
+// SRTF and preemptive Priority: the dispatched process keeps the CPU until it finishes or
+// an arrival gets ahead of it in the heap, so the clock only stops at arrivals and completions
+void runPreemptive(ProcessTable *t, const int *order, int srtf) {
+    int count = t->count;
+    long long *key = malloc((count ? count : 1) * sizeof(long long));
+    int *remaining = malloc((count ? count : 1) * sizeof(int));
+    ReadyHeap ready = {malloc((count ? count : 1) * sizeof(int)), 0, key, count ? count : 1};
+    long long time = 0, waitSum = 0;
+    int next = 0;
+
+    for (int pos = 0; pos < count; ++pos)
+        remaining[pos] = t->burstTime[order[pos]];
+
+    while (next < count || ready.size > 0) {
+        while (next < count && t->arrivalTime[order[next]] <= time) {
+            int i = order[next];
+            key[next] = preemptiveKey(t, i, srtf, remaining[next], t->arrivalTime[i]);
+            if (!skipEmptyBurst(t, i)) heapPush(&ready, next);
+            next++;
+        }
+
+        if (ready.size == 0) {
+            next = skipEmptyArrivals(t, order, next);
+            if (next == count) break;
+            simulateIdleTime(time, t->arrivalTime[order[next]]);
+            time = t->arrivalTime[order[next]];
+            continue;
+        }
+
+        int cur = heapPop(&ready);
+        long long end = time + remaining[cur];
+        // walk the arrivals before cur would finish, the first one ahead of it preempts it
+        while (next < count && t->arrivalTime[order[next]] < end) {
+            long long at = t->arrivalTime[order[next]];
+            if (srtf) key[cur] = remaining[cur] - (at - time);
+            while (next < count && t->arrivalTime[order[next]] <= at) {
+                int i = order[next];
+                key[next] = preemptiveKey(t, i, srtf, remaining[next], at);
+                if (!skipEmptyBurst(t, i)) heapPush(&ready, next);
+                next++;
+            }
+            if (heapBefore(&ready, ready.items[0], cur)) {
+                end = at;
+                break;
+            }
+        }
+
+        int i = order[cur];
+        remaining[cur] -= (int)(end - time);
+        runStretch(t, i, &time, end);
+        if (remaining[cur] > 0) {
+            key[cur] = preemptiveKey(t, i, srtf, remaining[cur], time);
+            heapPush(&ready, cur);
+        } else {
+            waitSum += time - t->arrivalTime[i] - t->burstTime[i];
+        }
+    }
+
+    free(ready.items);
+    free(key);
+    free(remaining);
+    printReportFooter("Average Waiting Time", (double)waitSum / count, 0);
+}
+
+// SRTF Algorithem
+void runSRTF(ProcessTable *t, const int *order) {
+    printReportHeader("SRTF");
+    runPreemptive(t, order, 1);
+}
+
+// Preemptive Priority Algorithem
+void runPreemptivePriority(ProcessTable *t, const int *order) {
+    printReportHeader("Preemptive Priority");
+    runPreemptive(t, order, 0);
+}
+
+// the MLFQ level queues, linked through next[] so they cost one int per process
+typedef struct {
+    int *next;
+    int *level;
+    int head[MAX_MLFQ_LEVELS];
+    int tail[MAX_MLFQ_LEVELS];
+    int queued;
+} LevelQueues;
+
+void levelEnqueue(LevelQueues *q, int l, int pos) {
+    q->next[pos] = -1;
+    q->level[pos] = l;
+    if (q->tail[l] < 0) q->head[l] = pos; else q->next[q->tail[l]] = pos;
+    q->tail[l] = pos;
+    q->queued++;
+}
+
+int levelDequeue(LevelQueues *q, int l) {
+    int pos = q->head[l];
+    q->head[l] = q->next[pos];
+    if (q->head[l] < 0) q->tail[l] = -1;
+    q->queued--;
+    return pos;
+}
+
+// the quantum of every MLFQ level from --mlfq, or quantum, 2*quantum, 4*quantum. returns the number of levels
+int mlfqQuanta(int quantum, int quanta[MAX_MLFQ_LEVELS]) {
+    if (schedulerConfig.mlfqLevels > 0) {
+        memcpy(quanta, schedulerConfig.mlfqQuanta, MAX_MLFQ_LEVELS * sizeof(int));
+        return schedulerConfig.mlfqLevels;
+    }
+    for (int l = 0; l < 3; ++l) quanta[l] = quantum << l;
+    return 3;
+}
+
+// MLFQ Algorithem: new processes enter the top level, a process that uses its whole quantum
+// drops one level, and an arrival preempts a process running below the top level
+void runMLFQ(ProcessTable *t, const int *order, int quantum) {
+    printReportHeader("MLFQ");
+
+    int quanta[MAX_MLFQ_LEVELS];
+    int levels = mlfqQuanta(quantum, quanta);
+
+    int count = t->count;
+    int *remaining = malloc((count ? count : 1) * sizeof(int));
+    LevelQueues q = {.next = malloc((count ? count : 1) * sizeof(int)),
+                     .level = malloc((count ? count : 1) * sizeof(int))};
+    for (int l = 0; l < levels; ++l) q.head[l] = q.tail[l] = -1;
+    long long time = 0, waitSum = 0, nextBoost = schedulerConfig.mlfqBoost;
+    int next = 0;
+
+    for (int pos = 0; pos < count; ++pos)
+        remaining[pos] = t->burstTime[order[pos]];
+
+    while (next < count || q.queued > 0) {
+        while (next < count && t->arrivalTime[order[next]] <= time) {
+            if (!skipEmptyBurst(t, order[next])) levelEnqueue(&q, 0, next);
+            next++;
+        }
+
+        // priority boost: the lower levels join the end of the top one, in level order
+        if (schedulerConfig.mlfqBoost > 0 && time >= nextBoost) {
+            for (int l = 1; l < levels; ++l) {
+                for (int pos = q.head[l]; pos >= 0; pos = q.next[pos]) q.level[pos] = 0;
+                if (q.head[l] < 0) continue;
+                if (q.tail[0] < 0) q.head[0] = q.head[l]; else q.next[q.tail[0]] = q.head[l];
+                q.tail[0] = q.tail[l];
+                q.head[l] = q.tail[l] = -1;
+            }
+            nextBoost = (time / schedulerConfig.mlfqBoost + 1) * schedulerConfig.mlfqBoost;
+        }
+
+        if (q.queued == 0) {
+            next = skipEmptyArrivals(t, order, next);
+            if (next == count) break;
+            simulateIdleTime(time, t->arrivalTime[order[next]]);
+            time = t->arrivalTime[order[next]];
+            continue;
+        }
+
+        int l = 0;
+        while (q.head[l] < 0) l++;
+        int cur = levelDequeue(&q, l);
+
+        int slice = remaining[cur] < quanta[l] ? remaining[cur] : quanta[l];
+        long long end = time + slice;
+        int preempted = 0;
+        if (l > 0 && next < count && t->arrivalTime[order[next]] < end) {
+            end = t->arrivalTime[order[next]];
+            preempted = 1;
+        }
+
+        int i = order[cur];
+        remaining[cur] -= (int)(end - time);
+        runStretch(t, i, &time, end);
+        if (remaining[cur] > 0) {
+            // like RR, the process goes back before the processes that arrived meanwhile
+            int down = (!preempted && slice == quanta[l] && l + 1 < levels) ? l + 1 : l;
+            levelEnqueue(&q, down, cur);
+        } else {
+            waitSum += time - t->arrivalTime[i] - t->burstTime[i];
+        }
+    }
+
+    free(remaining);
+    free(q.next);
+    free(q.level);
+    printReportFooter("Average Waiting Time", (double)waitSum / count, 0);
+}
+
+
+// one stretch of a core's timeline
+typedef struct {
+    long long start;
+    long long end;
+    int pos;
+} CoreSegment;
+
+// one core of the -c N simulation. processes with an affinity for it wait in pinned,
+// the others in local, where idle cores can steal them
+typedef struct {
+    ReadyHeap local;
+    ReadyHeap pinned;
+    int running;          // arrival position, -1 when idle
+    int slice;            // planned length of the running segment
+    long long segmentStart;
+    long long segmentEnd;
+    long long busy;
+    CoreSegment *timeline;
+    int timelineCount;
+    int timelineCapacity;
+} Core;
+
+// the state of runMultiCore shared by its helpers
+typedef struct {
+    ProcessTable *t;
+    const int *order;
+    Policy policy;
+    int cores;
+    Core *core;
+    long long *key;
+    int *remaining;
+    int *level;
+    long long seq;        // enqueue counter, the FIFO order of RR and of the MLFQ levels
+    int quanta[MAX_MLFQ_LEVELS];
+    int levels;
+    int quantum;
+} MultiCore;
+
+#define MLFQ_LEVEL_SHIFT 40
+
+// queue pos on core c at time now, keyed like the single CPU version of the policy
+void coreEnqueue(MultiCore *m, int c, int pos, long long now) {
+    int i = m->order[pos];
+    switch (m->policy) {
+        case POLICY_FCFS: m->key[pos] = pos; break;
+        case POLICY_SJF: m->key[pos] = m->t->burstTime[i]; break;
+        case POLICY_PRIORITY: m->key[pos] = m->t->priority[i]; break;
+        case POLICY_SRTF: m->key[pos] = m->remaining[pos]; break;
+        case POLICY_PREEMPTIVE_PRIORITY: m->key[pos] = preemptiveKey(m->t, i, 0, 0, now); break;
+        case POLICY_RR: m->key[pos] = m->seq++; break;
+        case POLICY_MLFQ: m->key[pos] = ((long long)m->level[pos] << MLFQ_LEVEL_SHIFT) + m->seq++; break;
+        default: break;
+    }
+    if (m->t->affinity[i] == c) heapPush(&m->core[c].pinned, pos);
+    else heapPush(&m->core[c].local, pos);
+}
+
+// a new arrival goes to the core it is pinned to, or to the least loaded one
+void placeArrival(MultiCore *m, int pos, long long now) {
+    int target = m->t->affinity[m->order[pos]];
+    if (target < 0 || target >= m->cores) {
+        int bestLoad = __INT_MAX__;
+        for (int c = 0; c < m->cores; ++c) {
+            Core *core = &m->core[c];
+            int load = core->local.size + core->pinned.size + (core->running >= 0);
+            if (load < bestLoad) {
+                bestLoad = load;
+                target = c;
+            }
+        }
+    }
+    coreEnqueue(m, target, pos, now);
+}
+
+// the better of the tops of core c's two queues, 0 for local, 1 for pinned, -1 if both are empty
+int coreBestQueue(MultiCore *m, int c) {
+    ReadyHeap *local = &m->core[c].local, *pinned = &m->core[c].pinned;
+    if (local->size == 0) return pinned->size ? 1 : -1;
+    if (pinned->size == 0) return 0;
+    return heapBefore(local, pinned->items[0], local->items[0]) ? 1 : 0;
+}
+
+// the next process for idle core c: its own best one, or the best one of the busiest core
+int corePick(MultiCore *m, int c) {
+    int queue = coreBestQueue(m, c);
+    if (queue == 1) return heapPop(&m->core[c].pinned);
+    if (queue == 0) return heapPop(&m->core[c].local);
+
+    int victim = -1;
+    for (int v = 0; v < m->cores; ++v)
+        if (m->core[v].local.size > 0 && (victim < 0 || m->core[v].local.size > m->core[victim].local.size))
+            victim = v;
+    return victim >= 0 ? heapPop(&m->core[victim].local) : -1;
+}
+
+// close the running segment of core c at time now
+void coreStop(MultiCore *m, int c, long long now) {
+    Core *core = &m->core[c];
+    int pos = core->running;
+    recordSegment(m->t, m->order[pos], core->segmentStart, now, c);
+    if (now > core->segmentStart) {
+        if (core->timelineCount == core->timelineCapacity) {
+            core->timelineCapacity = core->timelineCapacity ? core->timelineCapacity * 2 : 64;
+            core->timeline = realloc(core->timeline, core->timelineCapacity * sizeof(CoreSegment));
+        }
+        core->timeline[core->timelineCount++] = (CoreSegment){core->segmentStart, now, pos};
+        core->busy += now - core->segmentStart;
+        m->remaining[pos] -= (int)(now - core->segmentStart);
+    }
+    core->running = -1;
+}
+
+// -c N: the policy on N cores, each with its own run queues. arrivals go to the least loaded
+// core (or the one they are pinned to), idle cores steal from the busiest one, and the
+// preemptive policies preempt on the core the arrival was queued on. runs on the virtual clock
+void runMultiCore(ProcessTable *t, const int *order, Policy policy, int quantum) {
+    static const char *titles[POLICY_COUNT] = {"FCFS", "SJF", "Priority", "Round Robin", "SRTF",
+                                               "Preemptive Priority", "MLFQ"};
+    int count = t->count, cores = schedulerConfig.cores;
+    char mode[64];
+    snprintf(mode, sizeof(mode), "%s on %d cores", titles[policy], cores);
+    printReportHeader(mode);
+
+    MultiCore m = {.t = t, .order = order, .policy = policy, .cores = cores,
+                   .core = calloc(cores, sizeof(Core)),
+                   .key = malloc((count ? count : 1) * sizeof(long long)),
+                   .remaining = malloc((count ? count : 1) * sizeof(int)),
+                   .level = calloc(count ? count : 1, sizeof(int)),
+                   .quantum = quantum};
+    m.levels = mlfqQuanta(quantum, m.quanta);
+    for (int c = 0; c < cores; ++c) {
+        m.core[c].local.key = m.key;
+        m.core[c].pinned.key = m.key;
+        m.core[c].running = -1;
+    }
+    for (int pos = 0; pos < count; ++pos)
+        m.remaining[pos] = t->burstTime[order[pos]];
+
+    int preemptive = policy == POLICY_SRTF || policy == POLICY_PREEMPTIVE_PRIORITY || policy == POLICY_MLFQ;
+    long long time = 0, waitSum = 0, nextBoost = schedulerConfig.mlfqBoost;
+    int next = 0, done = 0;
+
+    while (done < count) {
+        // segments that end now: finished, or back in their core's queue
+        for (int c = 0; c < cores; ++c) {
+            Core *core = &m.core[c];
+            if (core->running < 0 || core->segmentEnd != time) continue;
+            int pos = core->running;
+            coreStop(&m, c, time);
+            if (m.remaining[pos] == 0) {
+                waitSum += time - t->arrivalTime[order[pos]] - t->burstTime[order[pos]];
+                done++;
+                continue;
+            }
+            if (policy == POLICY_MLFQ && core->slice == m.quanta[m.level[pos]] && m.level[pos] + 1 < m.levels)
+                m.level[pos]++;
+            coreEnqueue(&m, c, pos, time);
+        }
+
+        while (next < count && t->arrivalTime[order[next]] <= time) {
+            placeArrival(&m, next, time);
+            next++;
+        }
+
+        // MLFQ boost: everybody back to the top level, in the order they were queued
+        if (policy == POLICY_MLFQ && schedulerConfig.mlfqBoost > 0 && time >= nextBoost) {
+            long long seqMask = (1LL << MLFQ_LEVEL_SHIFT) - 1;
+            for (int pos = 0; pos < next; ++pos) {
+                m.level[pos] = 0;
+                m.key[pos] &= seqMask;
+            }
+            for (int c = 0; c < cores; ++c) {
+                heapRebuild(&m.core[c].local);
+                heapRebuild(&m.core[c].pinned);
+            }
+            nextBoost = (time / schedulerConfig.mlfqBoost + 1) * schedulerConfig.mlfqBoost;
+        }
+
+        // a better process waiting on a core preempts the one running there
+        if (preemptive) {
+            for (int c = 0; c < cores; ++c) {
+                Core *core = &m.core[c];
+                int queue = coreBestQueue(&m, c);
+                if (core->running < 0 || queue < 0) continue;
+                ReadyHeap *ready = queue ? &core->pinned : &core->local;
+                int cur = core->running;
+                if (policy == POLICY_SRTF) m.key[cur] = m.remaining[cur] - (time - core->segmentStart);
+                if (heapBefore(ready, ready->items[0], cur)) {
+                    coreStop(&m, c, time);
+                    coreEnqueue(&m, c, cur, time);
+                }
+            }
+        }
+
+        // idle cores take their next process
+        for (int c = 0; c < cores; ++c) {
+            Core *core = &m.core[c];
+            if (core->running >= 0) continue;
+            int pos = corePick(&m, c);
+            if (pos < 0) continue;
+            int slice = m.remaining[pos];
+            if (policy == POLICY_RR && quantum < slice) slice = quantum;
+            if (policy == POLICY_MLFQ && m.quanta[m.level[pos]] < slice) slice = m.quanta[m.level[pos]];
+            core->running = pos;
+            core->slice = slice;
+            core->segmentStart = time;
+            core->segmentEnd = time + slice;
+        }
+
+        // on to the next arrival or segment end
+        long long nextTime = next < count ? t->arrivalTime[order[next]] : -1;
+        for (int c = 0; c < cores; ++c)
+            if (m.core[c].running >= 0 && (nextTime < 0 || m.core[c].segmentEnd < nextTime))
+                nextTime = m.core[c].segmentEnd;
+        if (nextTime < 0) break;
+        time = nextTime;
+    }
+
+    // per core timelines, then how busy every core was
+    for (int c = 0; c < cores; ++c) {
+        Core *core = &m.core[c];
+        printf(">> Core %d\n", c);
+        long long last = 0;
+        for (int k = 0; k < core->timelineCount; ++k) {
+            CoreSegment *seg = &core->timeline[k];
+            if (seg->start > last) simulateIdleTime(last, seg->start);
+            int i = order[seg->pos];
+            printf("%lld → %lld: %s Running %s.\n", seg->start, seg->end, t->name[i], t->description[i]);
+            last = seg->end;
+        }
+        printf("\n");
+    }
+    printf(">> Core Utilization (%lld time units)\n", time);
+    for (int c = 0; c < cores; ++c)
+        printf("   core %d : %lld busy, %.2f%%\n", c, m.core[c].busy, time ? 100.0 * m.core[c].busy / time : 0.0);
+
+    for (int c = 0; c < cores; ++c) {
+        free(m.core[c].local.items);
+        free(m.core[c].pinned.items);
+        free(m.core[c].timeline);
+    }
+    free(m.core);
+    free(m.key);
+    free(m.remaining);
+    free(m.level);
+
+    if (policy == POLICY_RR)
+        printReportFooter("Total Turnaround Time", time, 1);
+    else
+        printReportFooter("Average Waiting Time", (double)waitSum / count, 0);
+}
+
+
+// one report of the selected policy on the configured cores
+void runPolicy(ProcessTable *t, const int *order, Policy policy, int quantum) {
+    if (schedulerConfig.metricsPrefix) metricsBegin(t, policyNames[policy]);
+    if (schedulerConfig.cores > 1) {
+        runMultiCore(t, order, policy, quantum);
+        metricsEnd(t, policyNames[policy]);
+        return;
+    }
+    if (schedulerConfig.workload) workloadBegin(t);
+    switch (policy) {
+        case POLICY_FCFS: runFCFS(t, order); break;
+        case POLICY_SJF: runSJF(t, order); break;
+        case POLICY_PRIORITY: runPriority(t, order); break;
+        case POLICY_RR: runRR(t, order, quantum); break;
+        case POLICY_SRTF: runSRTF(t, order); break;
+        case POLICY_PREEMPTIVE_PRIORITY: runPreemptivePriority(t, order); break;
+        case POLICY_MLFQ: runMLFQ(t, order, quantum); break;
+        default: break;
+    }
+    if (schedulerConfig.workload) workloadEnd(t, policyNames[policy]);
+    poolStop(policyNames[policy]);
+    metricsEnd(t, policyNames[policy]);
+}
+
+// every report in its own process, on its own copy of the table, writing into its own
+// tmpfile. they run side by side (in real time too), and are printed in order once all
+// are done. returns -1 if it could not start them, so the caller runs them one by one
+int runPoliciesConcurrently(ProcessTable *t, const int *order, int quantum) {
+    int count = schedulerConfig.policyCount;
+    FILE *reports[MAX_POLICIES] = {0};
+    pid_t pids[MAX_POLICIES];
+    int started = 0;
+
+    fflush(stdout);
+    for (; started < count; ++started) {
+        reports[started] = tmpfile();
+        if (!reports[started]) break;
+        pids[started] = fork();
+        if (pids[started] < 0) {
+            fclose(reports[started]);
+            break;
+        }
+        if (pids[started] == 0) {
+            dup2(fileno(reports[started]), STDOUT_FILENO);
+            runPolicy(t, order, schedulerConfig.policies[started], quantum);
+            fflush(stdout);
+            // _exit skips atexit, the report's own counts are printed here
+            if (os_instrument_on) os_instrument_summary();
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    // could not start them all: drop the ones that did start, the caller starts over
+    if (started < count) {
+        for (int p = 0; p < started; ++p) {
+            kill(pids[p], SIGKILL);
+            waitpid(pids[p], NULL, 0);
+            fclose(reports[p]);
+        }
+        return -1;
+    }
+
+    char buffer[1 << 16];
+    for (int p = 0; p < count; ++p) {
+        int status;
+        unsigned long long wait = os_instrument_begin();
+        waitpid(pids[p], &status, 0);
+        os_instrument_end(OS_WAIT, wait);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+            fprintf(stderr, "The %s report did not finish\n", policyNames[schedulerConfig.policies[p]]);
+        rewind(reports[p]);
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), reports[p])) > 0)
+            fwrite(buffer, 1, n, stdout);
+        fclose(reports[p]);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+
 void runCPUScheduler(char *filePath, int quantum) {
-    Process procList[MAX_PROCESSES];
-    int count = loadProcessesFromCSV(filePath, procList);
+    ProcessTable procTable = {0};
+    unsigned long long load = os_instrument_begin();
+    loadProcessesFromCSV(filePath, &procTable);
+    os_instrument_end(OS_READ, load);
+    int *order = sortByArrival(&procTable);
+
+    if (schedulerConfig.policyCount == 0) {
+        Policy classic[] = {POLICY_FCFS, POLICY_SJF, POLICY_PRIORITY, POLICY_RR};
+        memcpy(schedulerConfig.policies, classic, sizeof(classic));
+        schedulerConfig.policyCount = 4;
+    }
+
+    if (schedulerConfig.sequential || schedulerConfig.policyCount == 1 ||
+        runPoliciesConcurrently(&procTable, order, quantum) < 0) {
+        for (int p = 0; p < schedulerConfig.policyCount; ++p)
+            runPolicy(&procTable, order, schedulerConfig.policies[p], quantum);
+    }
 
-    runFCFS(procList, count);
-    runSJF(procList, count);
-    runPriority(procList, count);
-    runRR(procList, count, quantum);
+    free(order);
+    freeProcessTable(&procTable);
 }
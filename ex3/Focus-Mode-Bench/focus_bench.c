@@ -0,0 +1,255 @@
+// signal delivery benchmark for Focus-Mode: generator processes fire distractions at a blocked
+// Focus-Mode event loop, which takes them only at the end of every round like the real thing
+#include "../Focus-Mode.c"
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define MAX_CONFIGS 16
+
+// shared with the generators (a mapped tmpfile, MAP_ANONYMOUS isn't in POSIX)
+typedef struct {
+    long long pendingSince[3]; // standard signals: send time of the oldest one not taken yet, 0 if none
+    int nextSequence;          // real-time signals: the payload of the last one sent
+    long long sent;
+    long long failed;          // sigqueue said EAGAIN, the real-time queue was full
+    long long capacity;
+    long long sendTime[];      // real-time signals: send time of every payload, while it fits
+} BenchShared;
+
+typedef struct {
+    int generators;
+    int rate;      // distractions per second of every generator
+    int seconds;
+    int rounds[MAX_CONFIGS];   // round durations in ms, 0: take every distraction right away
+    int roundCount;
+    int types[MAX_CONFIGS];    // how many of the three distractions are fired
+    int typeCount;
+    int realtime[2];           // standard and/or real-time signals
+    int realtimeCount;
+} BenchConfig;
+
+static BenchConfig benchConfig = {.generators = 4, .rate = 5000, .seconds = 2,
+                                  .rounds = {0, 10, 100}, .roundCount = 3,
+                                  .types = {1, 3}, .typeCount = 2,
+                                  .realtime = {0, 1}, .realtimeCount = 2};
+
+long long nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// "0,10,100" -> list, returns the count or -1
+int parseList(char *text, int *list, int min) {
+    int count = 0;
+    for (char *item = strtok(text, ","); item; item = strtok(NULL, ",")) {
+        if (count == MAX_CONFIGS || atoi(item) < min) return -1;
+        list[count++] = atoi(item);
+    }
+    return count;
+}
+
+int configureBench(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            benchConfig.generators = atoi(argv[++i]);
+            if (benchConfig.generators < 1) return -1;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            benchConfig.rate = atoi(argv[++i]);
+            if (benchConfig.rate < 1) return -1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            benchConfig.seconds = atoi(argv[++i]);
+            if (benchConfig.seconds < 1) return -1;
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            if ((benchConfig.roundCount = parseList(argv[++i], benchConfig.rounds, 0)) < 1) return -1;
+        } else if (strcmp(argv[i], "--types") == 0 && i + 1 < argc) {
+            if ((benchConfig.typeCount = parseList(argv[++i], benchConfig.types, 1)) < 1) return -1;
+            for (int k = 0; k < benchConfig.typeCount; ++k)
+                if (benchConfig.types[k] > 3) return -1;
+        } else if (strcmp(argv[i], "--signals") == 0 && i + 1 < argc) {
+            benchConfig.realtimeCount = 0;
+            for (char *kind = strtok(argv[++i], ","); kind; kind = strtok(NULL, ",")) {
+                if (benchConfig.realtimeCount == 2) return -1;
+                if (strcmp(kind, "std") == 0) benchConfig.realtime[benchConfig.realtimeCount++] = 0;
+                else if (strcmp(kind, "rt") == 0) benchConfig.realtime[benchConfig.realtimeCount++] = 1;
+                else return -1;
+            }
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+BenchShared *mapShared(long long capacity) {
+    size_t size = sizeof(BenchShared) + capacity * sizeof(long long);
+    FILE *file = tmpfile();
+    if (!file || ftruncate(fileno(file), size) < 0) {
+        perror("Unable to create the shared memory");
+        exit(EXIT_FAILURE);
+    }
+    BenchShared *shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(file), 0);
+    fclose(file);
+    if (shared == MAP_FAILED) {
+        perror("Unable to map the shared memory");
+        exit(EXIT_FAILURE);
+    }
+    shared->capacity = capacity;
+    return shared;
+}
+
+// one generator: rate distractions a second for the whole run, round robin over the types
+void runGenerator(BenchShared *shared, pid_t target, int types, long long until) {
+    long long start = nowUs();
+    long long sent = 0, failed = 0;
+    struct timespec pace = {0, 1000000}; // catch up every ms
+    for (long long now = start; now < until; now = nowUs()) {
+        long long due = (now - start) * benchConfig.rate / 1000000;
+        for (; sent < due; ++sent) {
+            int type = sent % types;
+            if (focusConfig.realtime) {
+                int sequence = __atomic_add_fetch(&shared->nextSequence, 1, __ATOMIC_RELAXED);
+                if (sequence < shared->capacity) shared->sendTime[sequence] = nowUs();
+                union sigval value = {.sival_int = sequence};
+                if (sigqueue(target, focusSignals[type], value) < 0) failed++;
+            } else {
+                long long idle = 0;
+                __atomic_compare_exchange_n(&shared->pendingSince[type], &idle, nowUs(), 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+                kill(target, focusSignals[type]);
+            }
+        }
+        nanosleep(&pace, NULL);
+    }
+    __atomic_add_fetch(&shared->sent, sent - failed, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&shared->failed, failed, __ATOMIC_RELAXED);
+}
+
+int compareLatency(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+// the distractions taken since the last call are handled now: one latency sample each
+void handleBatch(FocusLoop *loop, BenchShared *shared, long long **samples, long long *count,
+                 long long *capacity, long long *handled) {
+    long long now = nowUs();
+    for (int k = 0; k < loop->eventCount; ++k) {
+        const FocusEvent *event = &loop->events[k];
+        long long since = 0;
+        if (focusConfig.realtime) {
+            if (event->sequence > 0 && event->sequence < shared->capacity)
+                since = shared->sendTime[event->sequence];
+        } else {
+            since = __atomic_exchange_n(&shared->pendingSince[event->type], 0, __ATOMIC_ACQUIRE);
+        }
+        if (since <= 0) continue;
+        if (*count == *capacity) {
+            *capacity = *capacity ? *capacity * 2 : 4096;
+            *samples = realloc(*samples, *capacity * sizeof(**samples));
+            if (!*samples) {
+                perror("Unable to store the latencies");
+                exit(EXIT_FAILURE);
+            }
+        }
+        (*samples)[(*count)++] = now - since;
+    }
+    *handled += loop->eventCount;
+    loop->eventCount = 0;
+    sigemptyset(&loop->received);
+}
+
+void runConfig(int roundMs, int types, int realtime) {
+    focusConfig.realtime = realtime;
+    focusConfig.tickMs = roundMs;
+    focusSignals[0] = realtime ? SIGRTMIN : SIG_EMAIL;
+    focusSignals[1] = realtime ? SIGRTMIN + 1 : SIG_REMIND;
+    focusSignals[2] = realtime ? SIGRTMIN + 2 : SIG_DB;
+
+    sigset_t actions;
+    sigemptyset(&actions);
+    for (int k = 0; k < 3; ++k) sigaddset(&actions, focusSignals[k]);
+    FocusLoop loop;
+    if (openFocusLoop(&loop, &actions) < 0) exit(EXIT_FAILURE);
+
+    long long capacity = (long long)benchConfig.generators * benchConfig.rate * (benchConfig.seconds + 1) + 1024;
+    BenchShared *shared = mapShared(realtime ? capacity : 0);
+    pid_t target = getpid();
+    long long start = nowUs();
+    long long until = start + benchConfig.seconds * 1000000LL;
+    for (int g = 0; g < benchConfig.generators; ++g) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            runGenerator(shared, target, types, until);
+            _exit(0);
+        }
+    }
+
+    if (roundMs) {
+        struct itimerspec tick = {{roundMs / 1000, (roundMs % 1000) * 1000000L},
+                                  {roundMs / 1000, (roundMs % 1000) * 1000000L}};
+        timerfd_settime(loop.timer, 0, &tick, NULL);
+    }
+    long long *samples = NULL, count = 0, sampleCapacity = 0, handled = 0;
+    while (nowUs() < until) {
+        if (roundMs) {
+            // only the timer wakes us: the distractions stay pending in the kernel for the whole round,
+            // so identical standard signals collapse and the real-time queue fills like in Focus-Mode
+            uint64_t expirations;
+            if (read(loop.timer, &expirations, sizeof(expirations)) != sizeof(expirations)) continue;
+        } else {
+            waitFocusEvents(&loop, 100);
+        }
+        drainFocusSignals(&loop);
+        handleBatch(&loop, shared, &samples, &count, &sampleCapacity, &handled);
+    }
+    while (wait(NULL) > 0) {
+    }
+    long long elapsed = nowUs() - start;
+    drainFocusSignals(&loop);
+    handleBatch(&loop, shared, &samples, &count, &sampleCapacity, &handled);
+    closeFocusLoop(&loop);
+
+    qsort(samples, count, sizeof(*samples), compareLatency);
+    long long p50 = count ? samples[count / 2] : 0;
+    long long p99 = count ? samples[count * 99 / 100] : 0;
+    long long dropped = shared->sent > handled ? shared->sent - handled : 0;
+    printf("%8d %5d %4s %10lld %8lld %10lld %9lld %12.0f %10lld %10lld\n", roundMs, types, realtime ? "rt" : "std",
+           shared->sent, shared->failed, handled, dropped, handled * 1e6 / elapsed, p50, p99);
+    fflush(stdout);
+
+    free(samples);
+    munmap(shared, sizeof(BenchShared) + shared->capacity * sizeof(long long));
+}
+
+int main(int argc, char *argv[]) {
+    if (configureBench(argc, argv) < 0) {
+        printf("Usage: %s [-g generators] [-r rate-per-generator] [-s seconds] [--rounds 0,10,100] "
+               "[--types 1,3] [--signals std,rt]\n", argv[0]);
+        return 1;
+    }
+    // nothing comes in from stdin, the generators bring every distraction
+    focusConfig.script = "/dev/null";
+
+    // keep all six signals blocked for the whole run, a late one must not kill us between runs
+    sigset_t all;
+    sigemptyset(&all);
+    sigaddset(&all, SIG_EMAIL);
+    sigaddset(&all, SIG_REMIND);
+    sigaddset(&all, SIG_DB);
+    for (int k = 0; k < 3; ++k) sigaddset(&all, SIGRTMIN + k);
+    sigprocmask(SIG_BLOCK, &all, NULL);
+
+    printf("%d generators x %d/s for %ds\n", benchConfig.generators, benchConfig.rate, benchConfig.seconds);
+    printf("round_ms types sig       sent   failed    handled   dropped   handled/s    p50_us    p99_us\n");
+    for (int r = 0; r < benchConfig.roundCount; ++r)
+        for (int t = 0; t < benchConfig.typeCount; ++t)
+            for (int s = 0; s < benchConfig.realtimeCount; ++s)
+                runConfig(benchConfig.rounds[r], benchConfig.types[t], benchConfig.realtime[s]);
+    return 0;
+}
@@ -1,9 +1,16 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <signal.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 
 /*
 Define the signals of every functionality
@@ -12,6 +19,44 @@ Define the signals of every functionality
 #define SIG_REMIND SIGUSR2 // Reminder to pick up delivery
 #define SIG_DB SIGALRM     // Doorbell ringing
 
+// how the rounds are driven
+typedef struct {
+    int events;         // signalfd + epoll loop instead of scanf and sigpending
+    const char *script; // read the distractions from this file instead of stdin
+    int tickMs;         // a round lasts duration ticks of tickMs each instead of duration inputs (0: inputs)
+    int realtime;       // SIGRTMIN+0..2 sent with sigqueue: they queue, so every distraction is counted
+} FocusConfig;
+
+static FocusConfig focusConfig = {0};
+// the signal of every distraction, SIG_EMAIL SIG_REMIND SIG_DB or the real-time ones
+static int focusSignals[3];
+// the payload of the last distraction we queued (real-time mode)
+static int focusSequence = 0;
+
+int configureFocusMode(int argc, char *argv[]) {
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--events") == 0) {
+            focusConfig.events = 1;
+        } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            focusConfig.script = argv[++i];
+        } else if (strcmp(argv[i], "--rt") == 0) {
+            focusConfig.realtime = 1;
+        } else if (strcmp(argv[i], "--tick-ms") == 0 && i + 1 < argc) {
+            focusConfig.tickMs = atoi(argv[++i]);
+            if (focusConfig.tickMs < 1) {
+                fprintf(stderr, "The tick has to be at least 1 ms\n");
+                return -1;
+            }
+        } else {
+            fprintf(stderr, "Unknown Focus-Mode option: %s\n", argv[i]);
+            return -1;
+        }
+    }
+    // a script, a clock or a queue only make sense in the event loop
+    if (focusConfig.script || focusConfig.tickMs || focusConfig.realtime) focusConfig.events = 1;
+    return 0;
+}
+
 // function that implement the output for task 1 = email notification
 void handle_email()
 {
@@ -52,26 +97,283 @@ int check(sigset_t set, int signum, struct sigaction sa) {
     return 0;
 }
 
+// the distractions read ahead from stdin or the script, one per non-blank char
+typedef struct {
+    int fd;
+    int polled;    // 0 for a regular file: epoll can't watch it, it's always ready
+    int eof;
+    int start, end;
+    char buffer[4096];
+} FocusInput;
+
+// one distraction read from the signalfd
+typedef struct {
+    int type;     // 0 email, 1 reminder, 2 doorbell
+    int sequence; // the sigqueue payload, 0 for a plain kill
+    int arrival;
+} FocusEvent;
+
+// the event loop: every distraction signal stays blocked and is read from a signalfd as soon as
+// it arrives, stdin and the tick timer are watched by the same epoll
+typedef struct {
+    int epoll;
+    int signals;   // signalfd of the three focusSignals
+    int timer;     // timerfd of the ticks, -1 when the input drives the rounds
+    FocusInput input;
+    sigset_t received; // the distractions that reached us since the end of the last round
+    FocusEvent *events; // and every one of them, in the order the signalfd gave them
+    int eventCount;
+    int eventCapacity;
+} FocusLoop;
+
+int watchFocusFd(FocusLoop *loop, int fd) {
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+    return epoll_ctl(loop->epoll, EPOLL_CTL_ADD, fd, &ev);
+}
+
+int openFocusLoop(FocusLoop *loop, sigset_t *actions) {
+    loop->input.fd = STDIN_FILENO;
+    loop->input.polled = 1;
+    loop->input.eof = 0;
+    loop->input.start = loop->input.end = 0;
+    loop->timer = -1;
+    sigemptyset(&loop->received);
+    loop->events = NULL;
+    loop->eventCount = loop->eventCapacity = 0;
+
+    if (focusConfig.script) {
+        loop->input.fd = open(focusConfig.script, O_RDONLY);
+        if (loop->input.fd < 0) {
+            perror(focusConfig.script);
+            return -1;
+        }
+    }
+    loop->epoll = epoll_create1(0);
+    loop->signals = signalfd(-1, actions, SFD_NONBLOCK);
+    if (loop->epoll < 0 || loop->signals < 0 || watchFocusFd(loop, loop->signals) < 0) {
+        perror("Focus-Mode event loop");
+        return -1;
+    }
+    if (watchFocusFd(loop, loop->input.fd) < 0) {
+        if (errno != EPERM) {
+            perror("Focus-Mode event loop");
+            return -1;
+        }
+        loop->input.polled = 0;
+    }
+    if (focusConfig.tickMs) {
+        loop->timer = timerfd_create(CLOCK_MONOTONIC, 0);
+        if (loop->timer < 0 || watchFocusFd(loop, loop->timer) < 0) {
+            perror("Focus-Mode tick timer");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void closeFocusLoop(FocusLoop *loop) {
+    if (loop->timer >= 0) close(loop->timer);
+    close(loop->signals);
+    close(loop->epoll);
+    if (focusConfig.script) close(loop->input.fd);
+    free(loop->events);
+}
+
+// read every distraction signal queued on the signalfd
+void drainFocusSignals(FocusLoop *loop) {
+    struct signalfd_siginfo info[64];
+    ssize_t n;
+    while ((n = read(loop->signals, info, sizeof(info))) > 0) {
+        for (size_t k = 0; k < n / sizeof(info[0]); ++k) {
+            int type = 0;
+            while (type < 2 && focusSignals[type] != (int)info[k].ssi_signo) type++;
+            sigaddset(&loop->received, info[k].ssi_signo);
+            if (loop->eventCount == loop->eventCapacity) {
+                loop->eventCapacity = loop->eventCapacity ? loop->eventCapacity * 2 : 256;
+                loop->events = realloc(loop->events, loop->eventCapacity * sizeof(*loop->events));
+                if (!loop->events) {
+                    perror("Focus-Mode events");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            FocusEvent *event = &loop->events[loop->eventCount];
+            event->type = type;
+            event->sequence = info[k].ssi_code == SI_QUEUE ? info[k].ssi_int : 0;
+            event->arrival = loop->eventCount++;
+        }
+    }
+}
+
+int compareFocusEvents(const void *a, const void *b) {
+    const FocusEvent *x = a, *y = b;
+    if (x->sequence != y->sequence) return x->sequence < y->sequence ? -1 : 1;
+    return x->arrival - y->arrival;
+}
+
+// real-time mode, end of a round: how many of each distraction came, in the order they were sent.
+// the kernel hands queued real-time signals lowest signal first, so the payloads put them back in order
+void reportFocusCounts(FocusLoop *loop) {
+    qsort(loop->events, loop->eventCount, sizeof(*loop->events), compareFocusEvents);
+    int counts[3] = {0, 0, 0};
+    int numbered = 0, missing = 0, first = 0, last = 0;
+    for (int k = 0; k < loop->eventCount; ++k) {
+        const FocusEvent *event = &loop->events[k];
+        counts[event->type]++;
+        if (event->sequence <= 0) continue;
+        if (numbered++ == 0) first = event->sequence;
+        else if (event->sequence > last + 1) missing += event->sequence - last - 1;
+        last = event->sequence;
+    }
+    printf("[Count:] %d emails, %d reminders, %d doorbells", counts[0], counts[1], counts[2]);
+    if (numbered) printf(", #%d..#%d", first, last);
+    if (missing) printf(", %d missing", missing);
+    printf("\n");
+}
+
+void fillFocusInput(FocusLoop *loop) {
+    FocusInput *in = &loop->input;
+    ssize_t n = read(in->fd, in->buffer, sizeof(in->buffer));
+    if (n < 0 && errno == EINTR) return;
+    if (n <= 0) {
+        // at the end the fd stays readable forever, stop watching it
+        in->eof = 1;
+        if (in->polled) epoll_ctl(loop->epoll, EPOLL_CTL_DEL, in->fd, NULL);
+        return;
+    }
+    in->start = 0;
+    in->end = (int)n;
+}
+
+// the next distraction already read, 0 if there is none yet
+char nextFocusToken(FocusInput *in) {
+    while (in->start < in->end) {
+        char c = in->buffer[in->start++];
+        if (!isspace((unsigned char)c)) return c;
+    }
+    return 0;
+}
+
+// wait up to timeoutMs (-1: forever) and serve whatever is ready. returns the ticks that passed
+int waitFocusEvents(FocusLoop *loop, int timeoutMs) {
+    struct epoll_event events[3];
+    int n = epoll_wait(loop->epoll, events, 3, timeoutMs);
+    int ticks = 0;
+    for (int k = 0; k < n; ++k) {
+        if (events[k].data.fd == loop->signals) {
+            drainFocusSignals(loop);
+        } else if (events[k].data.fd == loop->timer) {
+            uint64_t expirations;
+            if (read(loop->timer, &expirations, sizeof(expirations)) == sizeof(expirations))
+                ticks += (int)expirations;
+        } else if (loop->input.start == loop->input.end && !loop->input.eof) {
+            fillFocusInput(loop);
+        }
+    }
+    return ticks;
+}
+
+// -1 with errno EAGAIN when the real-time queue is full
+int sendDistraction(char choice) {
+    if (choice < '1' || choice > '3') return 0;
+    int signum = focusSignals[choice - '1'];
+    if (!focusConfig.realtime) return kill(getpid(), signum);
+
+    // the payload numbers the distractions, so the end of the round can put them back in order
+    union sigval value = {.sival_int = focusSequence + 1};
+    if (sigqueue(getpid(), signum, value) < 0) return -1;
+    focusSequence++;
+    return 0;
+}
+
+// a full queue empties into the signalfd, nothing is lost
+void queueDistraction(FocusLoop *loop, char choice) {
+    while (sendDistraction(choice) < 0 && errno == EAGAIN) drainFocusSignals(loop);
+}
+
+// one round driven by the input: every distraction is one tick, with the menu before it
+void runInputRound(FocusLoop *loop, int duration) {
+    char choice = '\0';
+    for (int j = 0; j < duration; j++) {
+        menu();
+        printf(">> ");
+        fflush(stdout);
+        char c;
+        while (!(c = nextFocusToken(&loop->input)) && !loop->input.eof) {
+            if (loop->input.polled) {
+                waitFocusEvents(loop, -1);
+            } else {
+                fillFocusInput(loop);
+            }
+        }
+        // like scanf, the end of the input leaves the last choice
+        if (c) choice = c;
+        if (choice == 'q') {
+            break; // Skip remaining iterations in this round
+        }
+        // but with --rt every signal is counted, so it isn't sent again for a choice nobody typed
+        if (!c && focusConfig.realtime) continue;
+        queueDistraction(loop, choice);
+    }
+}
+
+// one round on the clock: duration ticks of tickMs, the input only brings distractions (or q)
+void runTimedRound(FocusLoop *loop, int duration) {
+    struct itimerspec tick = {{focusConfig.tickMs / 1000, (focusConfig.tickMs % 1000) * 1000000L},
+                              {focusConfig.tickMs / 1000, (focusConfig.tickMs % 1000) * 1000000L}};
+    timerfd_settime(loop->timer, 0, &tick, NULL);
+
+    int ticks = 0;
+    while (ticks < duration) {
+        char c;
+        while ((c = nextFocusToken(&loop->input)) && c != 'q') queueDistraction(loop, c);
+        if (c == 'q') break;
+
+        // a script is read as fast as it goes, but the signals and the clock are served between reads
+        int timeout = -1;
+        if (!loop->input.polled && !loop->input.eof) {
+            fillFocusInput(loop);
+            timeout = 0;
+        }
+        ticks += waitFocusEvents(loop, timeout);
+    }
+
+    struct itimerspec stop = {{0, 0}, {0, 0}};
+    timerfd_settime(loop->timer, 0, &stop, NULL);
+}
+
 void runFocusMode(int numOfRounds, int duration) {
     struct sigaction sa1, sa2, sa3;
+    focusSignals[0] = focusConfig.realtime ? SIGRTMIN : SIG_EMAIL;
+    focusSignals[1] = focusConfig.realtime ? SIGRTMIN + 1 : SIG_REMIND;
+    focusSignals[2] = focusConfig.realtime ? SIGRTMIN + 2 : SIG_DB;
 
     // Initialize signal handlers
     sa1.sa_handler = handle_email;
     sigemptyset(&sa1.sa_mask);
     sa1.sa_flags = 0;
-    sigaction(SIG_EMAIL, &sa1, NULL);
+    sigaction(focusSignals[0], &sa1, NULL);
 
     sa2.sa_handler = handle_reminder;
     sigemptyset(&sa2.sa_mask);
     sa2.sa_flags = 0;
-    sigaction(SIG_REMIND, &sa2, NULL);
+    sigaction(focusSignals[1], &sa2, NULL);
 
     sa3.sa_handler = handle_doorbell;
     sigemptyset(&sa3.sa_mask);
     sa3.sa_flags = 0;
-    sigaction(SIG_DB, &sa3, NULL);
+    sigaction(focusSignals[2], &sa3, NULL);
 
     sigset_t actions;
+    FocusLoop loop;
+    if (focusConfig.events) {
+        // block the distractions for good before the signalfd takes them
+        sigemptyset(&actions);
+        sigaddset(&actions, focusSignals[0]);
+        sigaddset(&actions, focusSignals[1]);
+        sigaddset(&actions, focusSignals[2]);
+        sigprocmask(SIG_BLOCK, &actions, NULL);
+        if (openFocusLoop(&loop, &actions) < 0) exit(EXIT_FAILURE);
+    }
 
     // First time: global header
     printf("Entering Focus Mode. All distractions are blocked.\n");
@@ -81,9 +383,9 @@ void runFocusMode(int numOfRounds, int duration) {
         sigemptyset(&pending);
         sigemptyset(&actions);
 
-        sigaddset(&actions, SIG_EMAIL);
-        sigaddset(&actions, SIG_REMIND);
-        sigaddset(&actions, SIG_DB);
+        sigaddset(&actions, focusSignals[0]);
+        sigaddset(&actions, focusSignals[1]);
+        sigaddset(&actions, focusSignals[2]);
         sigprocmask(SIG_BLOCK, &actions, NULL);
 
         // Round header
@@ -91,28 +393,21 @@ void runFocusMode(int numOfRounds, int duration) {
         printf("                Focus Round %d                \n", i + 1);
         printf("──────────────────────────────────────────────\n");
 
-        char choice = '\0';
-        for (int j = 0; j < duration; j++) {
-            menu();
-            printf(">> ");
-            fflush(stdout);
-            scanf(" %c", &choice);
-            if (choice == 'q') {
-                break; // Skip remaining iterations in this round
-            }
-
-            switch (choice) {
-                case '1':
-                    kill(getpid(), SIG_EMAIL);
-                    break;
-                case '2':
-                    kill(getpid(), SIG_REMIND);
-                    break;
-                case '3':
-                    kill(getpid(), SIG_DB);
-                    break;
-                default:
-                    break;
+        if (focusConfig.events && focusConfig.tickMs) {
+            runTimedRound(&loop, duration);
+        } else if (focusConfig.events) {
+            runInputRound(&loop, duration);
+        } else {
+            char choice = '\0';
+            for (int j = 0; j < duration; j++) {
+                menu();
+                printf(">> ");
+                fflush(stdout);
+                scanf(" %c", &choice);
+                if (choice == 'q') {
+                    break; // Skip remaining iterations in this round
+                }
+                sendDistraction(choice);
             }
         }
 
@@ -121,19 +416,27 @@ void runFocusMode(int numOfRounds, int duration) {
         printf("        Checking pending distractions...      \n");
         printf("──────────────────────────────────────────────\n");
 
-        if (sigpending(&pending) == -1) {
+        if (focusConfig.events) {
+            // the signalfd already took them, a distraction is handled once
+            drainFocusSignals(&loop);
+            pending = loop.received;
+            sigemptyset(&loop.received);
+        } else if (sigpending(&pending) == -1) {
             perror("sigpending");
             exit(EXIT_FAILURE);
         }
 
         int counter = 0;
-        counter += check(pending, SIG_EMAIL, sa1);
-        counter += check(pending, SIG_REMIND, sa2);
-        counter += check(pending, SIG_DB, sa3);
+        counter += check(pending, focusSignals[0], sa1);
+        counter += check(pending, focusSignals[1], sa2);
+        counter += check(pending, focusSignals[2], sa3);
 
         if (counter == 0) {
             printf("No distractions reached you this round.\n");
+        } else if (focusConfig.realtime) {
+            reportFocusCounts(&loop);
         }
+        if (focusConfig.events) loop.eventCount = 0;
 
         printf("──────────────────────────────────────────────\n");
         printf("             Back to Focus Mode.              \n");
@@ -142,4 +445,5 @@ void runFocusMode(int numOfRounds, int duration) {
 
     // Final line after all rounds
     printf("Focus Mode complete. All distractions are now unblocked.\n");
+    if (focusConfig.events) closeFocusLoop(&loop);
 }
@@ -5,7 +5,8 @@
 #include "CPU-Scheduler.c"
 
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
+    // both parts take options after their two numbers (e.g. --virtual, --events)
+    if (argc < 4 || (argc > 4 && strcmp(argv[1], "CPU-Scheduler") != 0 && strcmp(argv[1], "Focus-Mode") != 0)) {
         printf("Usage: %s <Focus-Mode/CPU-Schedule> <Num-Of-Rounds/Processes.csv> <Round-Duration/Time-Quantum>",
                argv[0]);
         exit(0);
@@ -20,12 +21,24 @@ int main(int argc, char *argv[]) {
     if (strcmp(argv[1], "Focus-Mode") == 0) {
         int numOfRounds = atoi(argv[2]);
         int roundDuration = atoi(argv[3]);
+        if (configureFocusMode(argc - 4, argv + 4) < 0) {
+            printf("Usage: %s Focus-Mode <Num-Of-Rounds> <Round-Duration> [--events] [--script file] [--tick-ms N] [--rt]",
+                   argv[0]);
+            exit(0);
+        }
         runFocusMode(numOfRounds, roundDuration);
     }
 
     if (strcmp(argv[1], "CPU-Scheduler") == 0) {
         char *processesCsvFilePath = argv[2];
         int timeQuantum = atoi(argv[3]);
+        if (configureCPUScheduler(timeQuantum, argc - 4, argv + 4) < 0) {
+            printf("Usage: %s CPU-Scheduler <Processes.csv> <Time-Quantum> [--virtual|--real] "
+                   "[--policies FCFS,SJF,Priority,RR,SRTF,PPriority,MLFQ] [--aging N] "
+                   "[--mlfq Q1,Q2,...] [--mlfq-boost N] [-c cores] [--sequential] [--workers N] [--pool-stats] [--unit-ms N] [--workload] [--metrics prefix [--metrics-window N]]", argv[0]);
+            exit(0);
+        }
         runCPUScheduler(processesCsvFilePath, timeQuantum);
     }
+    return 0;
 }
\ No newline at end of file